@@ -0,0 +1,62 @@
+#' File Profile
+#' 
+#' Count the lines of a file, estimate its number of distinct lines and keys,
+#' and find its most frequent keys, all in one pass.
+#' 
+#' @details
+#' The file is read once, at about the speed of \code{wc()}.  The distinct
+#' counts are HyperLogLog estimates, with a relative standard error of about
+#' 0.8\%.  The most frequent keys are found with a Count-Min sketch, whose
+#' counts can only overestimate the true ones, by at most about 0.07\% of the
+#' number of lines (with high probability).  For files with few distinct
+#' keys, both are exact in practice.
+#' 
+#' With more than one thread (see \code{\link{set_threads}}), chunks of the
+#' file are profiled in parallel and the sketches are merged.
+#' 
+#' @param file
+#' Location of the file (as a string) to profile.
+#' @param key
+#' The key column, either as a number (counting from 1) or as a name from the
+#' header.  The default \code{0} uses whole lines as the keys.  Fields are
+#' split on \code{sep} without regard to quoting.
+#' @param sep
+#' The field separator; a single character.  Only used with \code{key}.
+#' @param header
+#' Is a header (line of column names) on the first line of the file?  If so,
+#' it is counted as a line but left out of the distinct counts and keys.
+#' @param ntop
+#' The number of most frequent keys to return, at most 100.
+#' 
+#' @return
+#' A list with the number of \code{lines} and \code{chars}, the estimated
+#' numbers of \code{distinct_lines} and \code{distinct_keys}, and a dataframe
+#' \code{top} of the most frequent keys and their estimated counts.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' file_profile(file, key="B")
+#' 
+#' @useDynLib filesampler R_fs_profile
+#' @export
+file_profile = function(file, key=0, sep=",", header=TRUE, ntop=10)
+{
+  check.is.string(file)
+  file = abspath(file)
+  check.is.string(sep)
+  check.is.flag(header)
+  check.is.natnum(ntop)
+  
+  if (nchar(sep) != 1)
+    stop("argument 'sep' must be a single character")
+  if (ntop > 100)
+    stop("argument 'ntop' must be at most 100")
+  
+  key = key_index(key, file, sep, header)
+  
+  ret = .Call(R_fs_profile, file, as.integer(header), as.integer(key), sep, as.integer(ntop))
+  
+  top = data.frame(key=ret[[5]], count=ret[[6]], stringsAsFactors=FALSE)
+  list(lines=ret[[1]], chars=ret[[2]], distinct_lines=ret[[3]], distinct_keys=ret[[4]], top=top)
+}
@@ -0,0 +1,49 @@
+#' File Line Range
+#' 
+#' Write a range of lines of an input text file.
+#' 
+#' @details
+#' Lines \code{first} through \code{last} (counting from 1, and not counting
+#' the header) are written to the output file.  The lines are found with the
+#' same newline counting pass as \code{wc_l()}, which stops at line
+#' \code{last}, and are then copied as in \code{file_tail()}.  Lines past the
+#' end of the file are ignored.
+#' 
+#' @param first,last
+#' The range of lines to write; positive integers with
+#' \code{first <= last}.
+#' @param infile
+#' Location of the file (as a string).
+#' @param outfile
+#' Output file location (as a string).
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?  If
+#' so, it is written first and line numbers start after it.
+#' @param verbose
+#' Should the number of lines and bytes written be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @seealso \code{\link{file_tail}}
+#' 
+#' @useDynLib filesampler R_fs_range
+#' @export
+file_range = function(first, last, infile, outfile=tempfile(), header=TRUE, verbose=FALSE)
+{
+  check.is.posint(first)
+  check.is.posint(last)
+  if (last < first)
+    stop("argument 'last' must be at least 'first'", call.=FALSE)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  stats = .Call(R_fs_range, as.integer(verbose), as.integer(header), as.double(first), as.double(last), infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -0,0 +1,71 @@
+#' Anytime File Sampler
+#' 
+#' Sample blocks of lines from an input text file until a time or byte
+#' budget runs out.
+#' 
+#' @details
+#' The input file is split into blocks of \code{blocksize} bytes, which are
+#' visited in a random order.  The lines starting in each visited block are
+#' written to the output file as it is visited, so the output grows the
+#' longer the sampler runs.  It stops once \code{time} seconds have passed,
+#' once \code{bytes} bytes have been read, or once every block has been
+#' visited, whichever comes first.  Since the visited blocks are a simple
+#' random sample of the blocks at every point, the result is a valid block
+#' sample (see \code{\link{file_sample_block}}) no matter when it stops.
+#' 
+#' Interrupting the sampler (e.g., with Ctrl-C) also stops it, keeping the
+#' lines written so far, rather than raising an error.
+#' 
+#' The blocks appear in the output in the order they were visited; the lines
+#' within a block stay in file order.
+#' 
+#' @param infile
+#' Location of the file (as a string) to be subsampled.
+#' @param outfile
+#' Output file location (as a string).
+#' @param time
+#' The time budget in seconds.  \code{Inf} for no limit.
+#' @param bytes
+#' The budget of bytes to read.  \code{Inf} for no limit.
+#' @param blocksize
+#' The size of each block in bytes.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?
+#' @param verbose
+#' Should the number of lines and blocks sampled be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats} (see
+#' \code{\link{print.fs_stats}}) with two additional elements:
+#' \code{coverage}, the fraction of the file in the visited blocks, and
+#' \code{stopped}, one of \code{"done"}, \code{"time"}, \code{"bytes"}, or
+#' \code{"interrupt"}.
+#' 
+#' @useDynLib filesampler R_fs_sample_anytime
+#' @export
+file_sample_anytime = function(infile, outfile=tempfile(), time=2, bytes=Inf, blocksize=2^16, header=TRUE, verbose=FALSE)
+{
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.posint(blocksize)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  if (!is.numeric(time) || length(time) != 1 || is.na(time) || time <= 0)
+    stop("argument 'time' must be a positive number")
+  if (!is.numeric(bytes) || length(bytes) != 1 || is.na(bytes) || bytes <= 0)
+    stop("argument 'bytes' must be a positive number")
+  
+  time_limit = if (is.infinite(time)) 0 else as.double(time)
+  byte_limit = if (is.infinite(bytes)) 0 else ceiling(bytes)
+  
+  ret = .Call(R_fs_sample_anytime, as.integer(verbose), as.integer(header), as.double(blocksize), time_limit, as.double(byte_limit), infile, outfile)
+  
+  stats = ret[[1]]
+  stats$coverage = ret[[2]]
+  stats$stopped = c("done", "time", "bytes", "interrupt")[ret[[3]] + 1L]
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -0,0 +1,72 @@
+#' Batch Exact File Sampler
+#' 
+#' Draw several exact samples from each of several input text files, reading
+#' each file only once per sampling pass.
+#' 
+#' @details
+#' This is the same as calling \code{file_sample_exact()} once for each
+#' sample size and input file, but each file is counted once, and all of its
+#' samples are written in a single scan.  The index sets of all the samples
+#' are drawn up front, so memory use is proportional to the total sample size.
+#' As with \code{file_sample_exact()}, if the samples are small next to the
+#' file, the scan reads only the parts of it that hold sampled lines.
+#' 
+#' With \code{nested=TRUE}, the samples of a file are nested: each sample
+#' holds all of the lines of the smaller ones.  Each is still a simple random
+#' sample of its size.  Otherwise they are drawn independently.
+#' 
+#' The scans of different files run in parallel on up to \code{max_reads}
+#' threads (see \code{\link{set_threads}}), so that only that many files are
+#' read at once.
+#' 
+#' @param nlines
+#' A vector of the number of lines to sample from each file.
+#' @param outfiles
+#' A character vector (or matrix) of output file locations, with
+#' \code{length(nlines)} outputs for each input file: the first
+#' \code{length(nlines)} are the samples of \code{infiles[1]}, and so on.
+#' @param infiles
+#' A character vector of input file locations.
+#' @param nested
+#' Should the samples of each file be nested?
+#' @param max_reads
+#' The most files to read at once.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv files?  If
+#' so, it is written to every output.
+#' @param verbose
+#' Should the number of samples written for each file be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters, summed over the files.  See \code{\link{print.fs_stats}}.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' outfiles = c(tempfile(), tempfile())
+#' 
+#' file_sample_batch(c(10, 50), outfiles, file, nested=TRUE)
+#' small = read.csv(outfiles[1])
+#' 
+#' @useDynLib filesampler R_fs_sample_batch
+#' @export
+file_sample_batch = function(nlines, outfiles, infiles, nested=FALSE, max_reads=2, header=TRUE, verbose=FALSE)
+{
+  if (!is.numeric(nlines) || length(nlines) == 0 || anyNA(nlines) || any(nlines < 0) || any(!is.inty(nlines)))
+    stop("argument 'nlines' must be a vector of natural numbers")
+  if (!is.character(infiles) || length(infiles) == 0 || anyNA(infiles))
+    stop("argument 'infiles' must be a character vector")
+  if (!is.character(outfiles) || length(outfiles) != length(nlines)*length(infiles) || anyNA(outfiles))
+    stop("argument 'outfiles' must be a character vector of length length(nlines)*length(infiles)")
+  infiles = sapply(infiles, abspath, USE.NAMES=FALSE)
+  check.is.flag(nested)
+  check.is.posint(max_reads)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  stats = .Call(R_fs_sample_batch, as.integer(verbose), as.integer(header), as.integer(nested), as.integer(max_reads), as.double(nlines), infiles, as.character(outfiles))
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
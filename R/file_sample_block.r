@@ -0,0 +1,56 @@
+#' Block File Sampler
+#' 
+#' Randomly sample contiguous blocks of lines from an input text file.
+#' 
+#' @details
+#' The input file is split into blocks of \code{blocksize} bytes, and each
+#' block is retained with probability \code{p}.  All lines starting in a
+#' retained block are written to the output file.  Only the retained blocks
+#' are read from disk, so for small \code{p} this is much faster than
+#' \code{file_sample_prop()}, which has to read the whole file.
+#' 
+#' Each line is retained with probability \code{p}, but the lines are
+#' retained in clusters rather than independently.  If neighbouring lines are
+#' similar (e.g., the file is sorted, or written in time order), estimates
+#' from a block sample are less precise than from a line sample of the same
+#' size.  Smaller blocks behave more like a line sample but cost more reads.
+#' 
+#' @param p
+#' The proportion of blocks to retain.
+#' @param infile
+#' Location of the file (as a string) to be subsampled.
+#' @param outfile
+#' Output file location (as a string).
+#' @param blocksize
+#' The size of each block in bytes.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?
+#' @param verbose
+#' Should the number of lines and blocks sampled be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @useDynLib filesampler R_fs_sample_block
+#' @export
+file_sample_block = function(p, infile, outfile=tempfile(), blocksize=2^20, header=TRUE, verbose=FALSE)
+{
+  check.is.scalar(p)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.posint(blocksize)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  if (p == 0)
+    stop("no lines available for input")
+  if (p < 0 || p > 1)
+    stop("Argument 'p' must be between 0 and 1")
+  
+  stats = .Call(R_fs_sample_block, as.integer(verbose), as.integer(header), as.double(p), as.double(blocksize), infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -0,0 +1,65 @@
+#' Bootstrap File Sampler
+#' 
+#' Draw samples with replacement (bootstrap replicates) from an input text
+#' file, without reading it into memory.
+#' 
+#' @details
+#' Each replicate holds \code{nlines} lines (after the header) drawn with
+#' replacement, with each line written as many times as it was drawn, in the
+#' order of the input.  All of the replicates are written in a single scan of
+#' the input, after its lines are counted.
+#' 
+#' The number of times each line is drawn is multinomial.  Rather than drawing
+#' and sorting \code{nlines} line numbers, the draws of each replicate are
+#' split between the two halves of the lines with a binomial, and so on down
+#' to single lines.  So the counts come out in line order as the scan reaches
+#' them, and memory use doesn't grow with the sample size or the number of
+#' lines.
+#' 
+#' @param outfiles
+#' A character vector of output file locations, one per replicate.
+#' @param infile
+#' Location of the file (as a string) to be resampled.
+#' @param nlines
+#' The number of lines in each replicate, at most \code{.Machine$integer.max}.
+#' The default, \code{NULL}, is the number of lines of the input (after the
+#' header), as in the usual bootstrap.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?  If
+#' so, it is written once to every replicate.
+#' @param verbose
+#' Should the number of replicates and lines written be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' outfiles = replicate(5, tempfile())
+#' 
+#' file_sample_bootstrap(outfiles, file)
+#' means = sapply(outfiles, function(f) mean(read.csv(f)$A))
+#' 
+#' @useDynLib filesampler R_fs_sample_bootstrap
+#' @export
+file_sample_bootstrap = function(outfiles, infile, nlines=NULL, header=TRUE, verbose=FALSE)
+{
+  if (!is.character(outfiles) || length(outfiles) == 0 || anyNA(outfiles))
+    stop("argument 'outfiles' must be a character vector")
+  check.is.string(infile)
+  infile = abspath(infile)
+  if (!is.null(nlines))
+    check.is.posint(nlines)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  if (is.null(nlines))
+    nlines = 0
+  
+  stats = .Call(R_fs_sample_bootstrap, as.integer(verbose), as.integer(header), as.double(nlines), infile, as.character(outfiles))
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
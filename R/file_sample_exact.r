@@ -10,9 +10,25 @@
 #' input file is scanned again line by line with the chosen lines dumped into a
 #' temporary file.
 #' 
+#' Samples of more than \code{2^24} (about 16.8 million) lines draw their index
+#' in increasing order a piece at a time instead (Vitter's sequential method A),
+#' so no sort is needed and the memory used doesn't grow with the sample size.
+#' 
 #' If the output file (the one pointed to by the return of this function) is
 #' "large" and to be read into memory (which isn't really appropriate for text
 #' files in the first place!), then this strategy is probably not appropriate.
+#' With \code{format="offsets"}, only the position of each sampled line is
+#' written, so the output stays small however large the lines are, and the
+#' second pass reads only the blocks holding sampled lines.
+#' 
+#' With a \code{state} file, the sample is drawn in one pass instead, with a
+#' streaming reservoir whose contents are kept in the state file.  The next call
+#' with the same state only reads the lines appended to the input since, and
+#' returns a uniform sample of the whole (grown) file.  This is meant for
+#' append-only files such as logs.  A last line without a newline is left for
+#' the next call, as it may still be being written.  If the input was truncated
+#' or replaced, the sampling starts over.  The state must be made by calls with
+#' the same \code{nlines} and \code{header}, and \code{nskip} must be 0.
 #' 
 #' @param nlines
 #' The (exact) number of lines to sample from the input file.
@@ -28,13 +44,21 @@
 #' @param verbose
 #' Should linecounts of the input file and the number of lines sampled be
 #' printed?
+#' @param state
+#' Optional location of a state file (as a string) for incremental sampling.
+#' It is created if it doesn't exist.
+#' @param format
+#' Either \code{"text"} to write the sampled lines to \code{outfile}, or
+#' \code{"offsets"} to write a binary record of where each of them is in
+#' \code{infile} instead; see \code{\link{read_offsets}}.
 #' 
 #' @return
-#' \code{NULL}
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
 #' 
-#' @useDynLib filesampler R_fs_sample_exact
+#' @useDynLib filesampler R_fs_sample_exact R_fs_sample_reservoir
 #' @export
-file_sample_exact = function(nlines, infile, outfile=tempfile(), header=TRUE, nskip=0, verbose=FALSE)
+file_sample_exact = function(nlines, infile, outfile=tempfile(), header=TRUE, nskip=0, verbose=FALSE, state=NULL, format="text")
 {
   check.is.posint(nlines)
   check.is.string(infile)
@@ -43,8 +67,24 @@ file_sample_exact = function(nlines, infile, outfile=tempfile(), header=TRUE, ns
   check.is.flag(header)
   check.is.natnum(nskip)
   check.is.flag(verbose)
+  format = output_format(format)
+  
+  if (!is.null(state))
+  {
+    check.is.string(state)
+    if (format != 0L)
+      stop("argument 'format' must be \"text\" when sampling with a state file")
+    if (nskip != 0)
+      stop("argument 'nskip' must be 0 when sampling with a state file")
+    
+    stats = .Call(R_fs_sample_reservoir, as.integer(verbose), as.integer(header), as.double(nlines), infile, outfile, path.expand(state))
+    class(stats) = "fs_stats"
+    
+    return(invisible(stats))
+  }
   
-  .Call(R_fs_sample_exact, as.integer(verbose), as.integer(header), as.integer(nskip), as.integer(nlines)-1L, infile, outfile)
+  stats = .Call(R_fs_sample_exact, as.integer(verbose), as.integer(header), as.double(nskip), as.double(nlines)-1, format, infile, outfile)
+  class(stats) = "fs_stats"
   
-  invisible()
+  invisible(stats)
 }
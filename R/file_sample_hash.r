@@ -0,0 +1,71 @@
+#' Hash File Sampler
+#' 
+#' Sample lines from an input text file by hashing their contents.
+#' 
+#' @details
+#' Each line is retained if a hash of it (or of its \code{key} field) and
+#' \code{seed} falls in the bottom \code{p} fraction of the hash values.  So
+#' as with \code{file_sample_prop()}, each line is retained with probability
+#' \code{p}, but whether a given line is retained does not depend on R's RNG
+#' or on the other lines in the file.
+#' 
+#' This makes the sample reproducible from the seed alone, and shardable:
+#' sampling the pieces of a dataset separately (say, on different machines)
+#' and combining the results gives the same lines as sampling the whole
+#' dataset at once.  The same lines are also retained when more data is
+#' appended to a file.
+#' 
+#' With a \code{key} column, all lines with the same key are retained
+#' together, e.g. all rows belonging to a sampled customer id.  Fields are
+#' split on \code{sep} without regard to quoting, and the line ending is not
+#' part of the last field.
+#' 
+#' @param p
+#' The proportion of lines (or keys) to retain.
+#' @param infile
+#' Location of the file (as a string) to be subsampled.
+#' @param outfile
+#' Output file location (as a string).
+#' @param key
+#' The column to hash, either as a number (counting from 1) or as a name from
+#' the header.  The default \code{0} hashes the whole line.
+#' @param sep
+#' The field separator; a single character.  Only used with \code{key}.
+#' @param seed
+#' The seed of the hash; a natural number.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?
+#' @param verbose
+#' Should linecounts of the input file and the number of lines sampled be
+#' printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @useDynLib filesampler R_fs_sample_hash
+#' @export
+file_sample_hash = function(p, infile, outfile=tempfile(), key=0, sep=",", seed=0, header=TRUE, verbose=FALSE)
+{
+  check.is.scalar(p)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.string(sep)
+  check.is.natnum(seed)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  if (nchar(sep) != 1)
+    stop("argument 'sep' must be a single character")
+  
+  key = key_index(key, infile, sep, header)
+  
+  if (p < 0 || p > 1)
+    stop("Argument 'p' must be between 0 and 1")
+  
+  stats = .Call(R_fs_sample_hash, as.integer(verbose), as.integer(header), as.double(p), as.double(seed), as.integer(key), sep, infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -0,0 +1,132 @@
+#' Distributed Exact File Sampler
+#' 
+#' Draw an exact sample of a file that is split into parts, one for each rank
+#' of a distributed (MPI) job.
+#' 
+#' @details
+#' The file is split into \code{nranks} parts of (nearly) equal bytes, and a
+#' part holds the lines that start in its bytes.  Each rank counts the lines of
+#' its part with \code{file_part_count()}, and the counts are gathered on every
+#' rank (an allgather).  \code{file_part_split()} then splits the sample among
+#' the parts as a uniform sample of the whole file would fall, and each rank
+#' samples its share of its part with \code{file_sample_part()}, reading only
+#' its part.  Each rank writes its own output; concatenated in rank order, they
+#' are an exact uniform sample of the whole file, in file order.
+#' 
+#' The package makes no MPI calls itself; the gather is left to whichever
+#' binding (pbdMPI, Rmpi) runs the job, so ranks are numbered from 0.
+#' \code{file_part_split()} draws from the RNG, so either call it on every rank
+#' with the same seed, or on one rank and broadcast the result.  The draws of
+#' \code{file_sample_part()} should then be independent across ranks, for
+#' example with seed \code{seed + rank}.
+#' 
+#' @param infile
+#' Location of the file (as a string) to be subsampled.
+#' @param rank,nranks
+#' The part of this rank (from 0), and the number of parts.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?  If
+#' so, it isn't counted, and part 0 writes it.
+#' @param nlines
+#' For \code{file_part_split()}, the number of lines to sample from the whole
+#' file.  For \code{file_sample_part()}, the share of this rank.
+#' @param counts
+#' The line counts of all of the parts, in rank order.
+#' @param outfile
+#' Output file location (as a string) of this rank.
+#' @param verbose
+#' Should the number of lines sampled be printed?
+#' 
+#' @return
+#' \code{file_part_count()} returns the number of lines of the part, and
+#' \code{file_part_split()} the share of each part.  \code{file_sample_part()}
+#' invisibly returns an object of class \code{fs_stats}; see
+#' \code{\link{print.fs_stats}}.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' 
+#' # the ranks of a 4 rank job, one after another
+#' counts = sapply(0:3, function(rank) file_part_count(file, rank, 4))
+#' parts = file_part_split(10, counts)
+#' outfiles = replicate(4, tempfile())
+#' for (rank in 0:3)
+#'   file_sample_part(parts[rank+1], counts, rank, file, outfiles[rank+1])
+#' 
+#' sampled = read.csv(text=unlist(lapply(outfiles, readLines)))
+#' 
+#' \dontrun{
+#' # with pbdMPI
+#' library(pbdMPI)
+#' rank = comm.rank()
+#' counts = unlist(allgather(file_part_count(file, rank, comm.size())))
+#' set.seed(1234)
+#' parts = file_part_split(10, counts)
+#' set.seed(1234 + rank)
+#' file_sample_part(parts[rank+1], counts, rank, file, sprintf("part%d.csv", rank))
+#' finalize()
+#' }
+#' 
+#' @name file_sample_part
+#' @rdname file_sample_part
+NULL
+
+
+
+#' @useDynLib filesampler R_fs_part_count
+#' @rdname file_sample_part
+#' @export
+file_part_count = function(infile, rank, nranks, header=TRUE)
+{
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.natnum(rank)
+  check.is.posint(nranks)
+  check.is.flag(header)
+  
+  if (rank >= nranks)
+    stop("argument 'rank' must be less than 'nranks'")
+  
+  .Call(R_fs_part_count, infile, as.integer(header), as.integer(rank), as.integer(nranks))
+}
+
+
+
+#' @useDynLib filesampler R_fs_part_split
+#' @rdname file_sample_part
+#' @export
+file_part_split = function(nlines, counts)
+{
+  check.is.natnum(nlines)
+  if (!is.numeric(counts) || length(counts) == 0 || anyNA(counts) || any(counts < 0))
+    stop("argument 'counts' must be a vector of natural numbers")
+  
+  .Call(R_fs_part_split, as.double(nlines), as.double(counts))
+}
+
+
+
+#' @useDynLib filesampler R_fs_sample_part
+#' @rdname file_sample_part
+#' @export
+file_sample_part = function(nlines, counts, rank, infile, outfile=tempfile(), header=TRUE, verbose=FALSE)
+{
+  check.is.natnum(nlines)
+  if (!is.numeric(counts) || length(counts) == 0 || anyNA(counts) || any(counts < 0))
+    stop("argument 'counts' must be a vector of natural numbers")
+  check.is.natnum(rank)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  if (rank >= length(counts))
+    stop("argument 'rank' must be less than length(counts)")
+  
+  stats = .Call(R_fs_sample_part, as.integer(verbose), as.integer(header), as.integer(rank), length(counts), as.double(counts[rank+1]), as.double(nlines), infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -9,6 +9,8 @@
 #' If the output file (the one pointed to by the return of this function) is
 #' "large" and to be read into memory (which isn't really appropriate for text
 #' files in the first place!), then this strategy is probably not appropriate.
+#' With \code{format="offsets"}, only the position of each sampled line is
+#' written, so the output stays small however large the lines are.
 #' 
 #' @param p
 #' Proportion to retain; should be a numeric value between 0 and 1.
@@ -26,13 +28,18 @@
 #' @param verbose
 #' Should linecounts of the input file and the number of lines sampled be
 #' printed?
+#' @param format
+#' Either \code{"text"} to write the sampled lines to \code{outfile}, or
+#' \code{"offsets"} to write a binary record of where each of them is in
+#' \code{infile} instead; see \code{\link{read_offsets}}.
 #' 
 #' @return
-#' \code{NULL}
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
 #' 
 #' @useDynLib filesampler R_fs_sample_prop
 #' @export
-file_sample_prop = function(p, infile, outfile=tempfile(), header=TRUE, nskip=0, nmax=0, verbose=FALSE)
+file_sample_prop = function(p, infile, outfile=tempfile(), header=TRUE, nskip=0, nmax=0, verbose=FALSE, format="text")
 {
   check.is.scalar(p)
   check.is.string(infile)
@@ -42,13 +49,15 @@ file_sample_prop = function(p, infile, outfile=tempfile(), header=TRUE, nskip=0,
   check.is.natnum(nskip)
   check.is.natnum(nmax)
   check.is.flag(verbose)
+  format = output_format(format)
   
   if (p == 0)
     stop("no lines available for input")
   if (p < 0 || p > 1)
     stop("Argument 'p' must be between 0 and 1")
   
-  .Call(R_fs_sample_prop, verbose, header, as.integer(nskip), as.integer(nmax), as.double(p), infile, outfile)
+  stats = .Call(R_fs_sample_prop, verbose, header, as.integer(nskip), as.integer(nmax), as.double(p), format, infile, outfile)
+  class(stats) = "fs_stats"
   
-  invisible()
+  invisible(stats)
 }
@@ -0,0 +1,72 @@
+#' Split File Sampler
+#' 
+#' Partition the lines of an input text file into several disjoint output
+#' files in a single pass, e.g. for train/test/validation splits.
+#' 
+#' @details
+#' Each line is written to \code{outfiles[i]} with probability \code{p[i]},
+#' and to none of them with probability \code{1 - sum(p)}.  So no line is
+#' written to more than one output, and if \code{sum(p) == 1}, every line is
+#' written to exactly one.  The input is read once, no matter the number of
+#' outputs.
+#' 
+#' With \code{method="random"}, each line's output is chosen with R's RNG, so
+#' use \code{set.seed()} for reproducible splits.  With \code{method="hash"},
+#' it is chosen from a hash of the line's contents and \code{seed} instead, so
+#' the same line always goes to the same output regardless of the RNG state,
+#' the order of the lines, or which file it is in.  This makes it possible to
+#' add data to a file and re-split it without moving lines between splits.
+#' Identical lines always go to the same output.
+#' 
+#' @param p
+#' A numeric vector of proportions, one per output.  They must be
+#' non-negative and sum to at most 1.
+#' @param outfiles
+#' A character vector of output file locations, the same length as \code{p}.
+#' @param infile
+#' Location of the file (as a string) to be split.
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?  If
+#' so, it is written to every output.
+#' @param method
+#' Either \code{"random"} or \code{"hash"}.  See details.
+#' @param seed
+#' The seed of the hash for \code{method="hash"}; a natural number.
+#' @param verbose
+#' Should the number of lines written to each output be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' outfiles = c(tempfile(), tempfile(), tempfile())
+#' 
+#' file_sample_split(c(.6, .2, .2), outfiles, file, method="hash")
+#' train = read.csv(outfiles[1])
+#' 
+#' @useDynLib filesampler R_fs_sample_split
+#' @export
+file_sample_split = function(p, outfiles, infile, header=TRUE, method="random", seed=0, verbose=FALSE)
+{
+  if (!is.numeric(p) || length(p) == 0 || anyNA(p))
+    stop("argument 'p' must be a numeric vector")
+  if (!is.character(outfiles) || length(outfiles) != length(p) || anyNA(outfiles))
+    stop("argument 'outfiles' must be a character vector the same length as 'p'")
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.flag(header)
+  method = match.arg(tolower(method), c("random", "hash"))
+  check.is.natnum(seed)
+  check.is.flag(verbose)
+  
+  if (any(p < 0) || sum(p) > 1)
+    stop("Argument 'p' must be non-negative and sum to at most 1")
+  
+  stats = .Call(R_fs_sample_split, as.integer(verbose), as.integer(header), as.double(p), as.integer(method == "hash"), as.double(seed), infile, outfiles)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
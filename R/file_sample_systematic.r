@@ -0,0 +1,49 @@
+#' Systematic File Sampler
+#' 
+#' Sample every k'th line from an input text file.
+#' 
+#' @details
+#' A starting line is chosen uniformly at random from the first \code{k} lines
+#' (after the header and any skipped lines), and then every \code{k}'th line
+#' from there on is retained.  Each line is retained with probability
+#' \code{1/k}, as with \code{file_sample_prop(p=1/k)}, but the sample size is
+#' (almost) fixed and the retained lines are evenly spread through the file.
+#' If the file has a periodic structure with period dividing \code{k}, the
+#' sample will be badly biased.
+#' 
+#' @param k
+#' The sampling interval; a positive integer.
+#' @param infile
+#' Location of the file (as a string) to be subsampled.
+#' @param outfile
+#' Output file location (as a string).
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?
+#' @param nskip
+#' Number of lines to skip. If \code{header=TRUE}, then this only applies to
+#' lines after the header.
+#' @param verbose
+#' Should linecounts of the input file and the number of lines sampled be
+#' printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @useDynLib filesampler R_fs_sample_systematic
+#' @export
+file_sample_systematic = function(k, infile, outfile=tempfile(), header=TRUE, nskip=0, verbose=FALSE)
+{
+  check.is.posint(k)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.flag(header)
+  check.is.natnum(nskip)
+  check.is.flag(verbose)
+  
+  stats = .Call(R_fs_sample_systematic, as.integer(verbose), as.integer(header), as.integer(nskip), as.integer(k), infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
@@ -0,0 +1,46 @@
+#' File Tail
+#' 
+#' Write the last lines of an input text file.
+#' 
+#' @details
+#' The file is read backward from the end until \code{n} lines have been
+#' found, so the time taken depends on the size of the output rather than on
+#' the size of the file.  The lines are then copied into the output file by
+#' the operating system where possible (\code{copy_file_range()} or
+#' \code{sendfile()}).  The input must be a regular file.
+#' 
+#' @param n
+#' The number of lines to write.  If the file has fewer, all of them are
+#' written.
+#' @param infile
+#' Location of the file (as a string).
+#' @param outfile
+#' Output file location (as a string).
+#' @param header
+#' Is a header (line of column names) on the first line of the csv file?  If
+#' so, it is written first and is not counted among the \code{n} lines.
+#' @param verbose
+#' Should the number of lines and bytes written be printed?
+#' 
+#' @return
+#' Invisibly, an object of class \code{fs_stats}; a list of per-phase timings
+#' and I/O counters for the run.  See \code{\link{print.fs_stats}}.
+#' 
+#' @seealso \code{\link{file_range}}
+#' 
+#' @useDynLib filesampler R_fs_tail
+#' @export
+file_tail = function(n, infile, outfile=tempfile(), header=TRUE, verbose=FALSE)
+{
+  check.is.natnum(n)
+  check.is.string(infile)
+  infile = abspath(infile)
+  check.is.string(outfile)
+  check.is.flag(header)
+  check.is.flag(verbose)
+  
+  stats = .Call(R_fs_tail, as.integer(verbose), as.integer(header), as.double(n), infile, outfile)
+  class(stats) = "fs_stats"
+  
+  invisible(stats)
+}
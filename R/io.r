@@ -0,0 +1,129 @@
+#' I/O Backend
+#' 
+#' Choose how \code{wc()} and the samplers read their input files.
+#' 
+#' @details
+#' With \code{"stdio"}, the input is read with ordinary blocking reads, one
+#' block at a time.  With \code{"io_uring"}, several large reads are kept in
+#' flight through the Linux io_uring interface, so the next blocks of the file
+#' are being read while the current one is processed.  This mostly helps on
+#' fast devices (NVMe) and network filesystems.
+#' 
+#' The default \code{"auto"} uses io_uring whenever it is available.  If the
+#' package was built without io_uring support, the running kernel does not
+#' support it, or the input is not a regular file (e.g., a pipe), the stdio
+#' reader is used instead.  The same fallback applies to \code{"io_uring"}.
+#' 
+#' @param backend
+#' One of \code{"auto"}, \code{"stdio"}, or \code{"io_uring"}.
+#' 
+#' @return
+#' Invisibly, the previous backend.
+#' 
+#' @examples
+#' library(filesampler)
+#' old = set_io_backend("stdio")
+#' set_io_backend(old)
+#' 
+#' @useDynLib filesampler R_fs_set_io_backend
+#' @export
+set_io_backend = function(backend="auto")
+{
+  check.is.string(backend)
+  backends = c("auto", "stdio", "io_uring")
+  backend = match.arg(tolower(backend), backends)
+  
+  old = .Call(R_fs_set_io_backend, match(backend, backends) - 1L)
+  
+  invisible(backends[old + 1L])
+}
+
+
+
+#' Page Cache Mode
+#' 
+#' Choose what the scans of \code{wc()} and the samplers leave in the page
+#' cache of the operating system.
+#' 
+#' @details
+#' With \code{"default"}, the kernel decides, as for any other program.  With
+#' \code{"keep"}, the kernel is told that the input is read sequentially and
+#' asked to read in the blocks ahead of the scan, so that they stay cached for
+#' a second pass over the same file (such as the sampling pass of
+#' \code{file_sample_exact()} after its line count).  With \code{"drop"}, each
+#' block is given back to the page cache once it has been read, so that a scan
+#' of a very large file doesn't push the data of other processes out of memory.
+#' With \code{"direct"}, the input is read with \code{O_DIRECT}, bypassing the
+#' page cache altogether.  This needs the io_uring reader (see
+#' \code{\link{set_io_backend}}) and a filesystem that supports it; otherwise
+#' it is the same as \code{"drop"}.
+#' 
+#' The hints are given with \code{posix_fadvise()}, so on systems without it
+#' (e.g., macOS) every mode is the same as \code{"default"}.
+#' 
+#' @param mode
+#' One of \code{"default"}, \code{"keep"}, \code{"drop"}, or \code{"direct"}.
+#' 
+#' @return
+#' Invisibly, the previous mode.
+#' 
+#' @examples
+#' library(filesampler)
+#' old = set_cache_mode("drop")
+#' set_cache_mode(old)
+#' 
+#' @useDynLib filesampler R_fs_set_cache_mode
+#' @export
+set_cache_mode = function(mode="default")
+{
+  check.is.string(mode)
+  modes = c("default", "keep", "drop", "direct")
+  mode = match.arg(tolower(mode), modes)
+  
+  old = .Call(R_fs_set_cache_mode, match(mode, modes) - 1L)
+  
+  invisible(modes[old + 1L])
+}
+
+
+
+#' Threads
+#' 
+#' Set the number of threads used by the exact sampler.
+#' 
+#' @details
+#' With more than one thread, \code{file_sample_exact()} counts the lines of
+#' the input in parallel, and then gathers the sampled lines in parallel, each
+#' thread handling a different stretch of the file.  The lines are written in
+#' file order, so for a given seed the sample is the same for any number of
+#' threads.
+#' 
+#' \code{file_sample_prop()} reads on one thread and, with more than one
+#' allowed, writes the sampled lines from a second one, so the scan doesn't
+#' wait on the output file.  This doesn't change the sample either.
+#' 
+#' With \code{nthreads=0} (the default), OpenMP decides, which usually means
+#' one thread per core (or \code{OMP_NUM_THREADS}).  If the package was built
+#' without OpenMP, everything runs on one thread.
+#' 
+#' @param nthreads
+#' The number of threads, or 0 for the OpenMP default.
+#' 
+#' @return
+#' Invisibly, the previous setting.
+#' 
+#' @examples
+#' library(filesampler)
+#' old = set_threads(1)
+#' set_threads(old)
+#' 
+#' @useDynLib filesampler R_fs_set_nthreads
+#' @export
+set_threads = function(nthreads=0)
+{
+  check.is.natnum(nthreads)
+  
+  old = .Call(R_fs_set_nthreads, as.integer(nthreads))
+  
+  invisible(old)
+}
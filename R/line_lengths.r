@@ -0,0 +1,75 @@
+#' Line Lengths
+#' 
+#' Summarize the distribution of the line lengths of a file.
+#' 
+#' @details
+#' The file is scanned once, at about the speed of \code{wc_l()}, and the
+#' length of every line is recorded in a histogram with power of 2 buckets:
+#' bucket \code{b} holds the lines of length \code{2^(b-1)} to
+#' \code{2^b - 1}.  Lengths are in bytes and include the newline, so that
+#' \code{mean * lines} is the size of the file.  This can be used to size
+#' buffers, or to estimate the size of a sample before taking it.
+#' 
+#' The minimum, maximum, and mean are exact.  The quantiles are interpolated
+#' within the histogram buckets, so are only accurate to within a factor of 2
+#' (and usually much better).
+#' 
+#' @param file
+#' Location of the file (as a string).
+#' @param probs
+#' Probabilities of the quantiles to estimate.
+#' 
+#' @return
+#' A list with the number of \code{lines} and \code{chars}, the \code{min},
+#' \code{max}, and \code{mean} line length, the estimated \code{quantiles},
+#' and the non-empty buckets of the \code{histogram} as a dataframe.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' line_lengths(file)
+#' 
+#' @useDynLib filesampler R_fs_wc_linelen
+#' @export
+line_lengths = function(file, probs=c(.5, .9, .99))
+{
+  check.is.string(file)
+  file = abspath(file)
+  if (!is.numeric(probs) || anyNA(probs) || any(probs < 0 | probs > 1))
+    stop("argument 'probs' must be a numeric vector of probabilities")
+  
+  ret = .Call(R_fs_wc_linelen, file)
+  
+  lines = ret[1L]
+  minlen = ret[3L]
+  maxlen = ret[4L]
+  counts = ret[-(1:4)]
+  
+  b = seq_along(counts) - 1
+  lower = ifelse(b == 0, 0, 2^(b - 1))
+  upper = 2^b - 1
+  
+  # interpolate within the bucket holding each rank, clamped to the range
+  # of lengths actually seen
+  cum = cumsum(counts)
+  quantiles = sapply(probs, function(p) {
+    if (lines == 0)
+      return(NA_real_)
+    
+    rank = p*lines
+    i = min(which(cum >= rank))
+    lo = max(lower[i], minlen)
+    hi = min(upper[i], maxlen)
+    before = if (i > 1) cum[i - 1] else 0
+    if (counts[i] == 0)
+      return(lo)
+    
+    lo + (rank - before)/counts[i] * (hi - lo)
+  })
+  names(quantiles) = paste0(format(100*probs, trim=TRUE), "%")
+  
+  keep = counts > 0
+  histogram = data.frame(lower=lower[keep], upper=upper[keep], count=counts[keep])
+  
+  list(lines=lines, chars=ret[2L], min=minlen, max=maxlen, mean=if (lines > 0) ret[2L]/lines else NA_real_, quantiles=quantiles, histogram=histogram)
+}
@@ -0,0 +1,38 @@
+#' Read an Offsets Sample
+#' 
+#' Read the output of \code{file_sample_exact()} or \code{file_sample_prop()}
+#' with \code{format="offsets"}.
+#' 
+#' @details
+#' The file has a record for each sampled line (and the header, if there is
+#' one), in the order of the lines: three unsigned 64-bit integers in native
+#' byte order, giving the number of the line from 0, its byte offset in the
+#' input, and its length in bytes including the newline.  Other programs can
+#' read it directly and \code{pread()} or \code{mmap()} the lines they need.
+#' 
+#' @param file
+#' Location of the offsets file (as a string).
+#' 
+#' @return
+#' A dataframe with a row per sampled line: its \code{line} number (from 1,
+#' counting the header), and the \code{offset} (from 0, as for
+#' \code{seek()}) and \code{length} of its bytes in the input.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' outfile = tempfile()
+#' file_sample_exact(10, file, outfile, format="offsets")
+#' read_offsets(outfile)
+#' 
+#' @useDynLib filesampler R_fs_read_offsets
+#' @export
+read_offsets = function(file)
+{
+  check.is.string(file)
+  file = abspath(file)
+  
+  ret = .Call(R_fs_read_offsets, file)
+  
+  data.frame(line=ret[, 1L] + 1, offset=ret[, 2L], length=ret[, 3L])
+}
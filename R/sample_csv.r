@@ -13,6 +13,18 @@
 #' passed to \code{read.csv()}, and so if their behavior is unclear, you should
 #' examine the \code{read.csv()} help file.
 #' 
+#' With \code{reader=NULL}, the sampled lines are instead split into fields in
+#' compiled code and parsed straight into the columns of the returned
+#' data.frame, without a temporary file for the proportional method and without
+#' a second parse in R for any of them.  Each column is logical, integer,
+#' double, or character, whichever is the narrowest that holds all of its
+#' sampled values; blank fields and \code{NA} are missing values (a blank field
+#' is the empty string in a character column).  Fields may be quoted with
+#' double quotes, but each line must be a whole record.  The only additional
+#' argument used is \code{sep} (a single character, \code{","} by default).
+#' With the proportional method, the same lines are retained as by
+#' \code{file_sample_prop()} for the same seed.
+#' 
 #' If \code{verbose=TRUE}, then something like:
 #' 
 #' \code{Read 12207 lines (0.001\%) of 12174948 line file.}
@@ -25,25 +37,31 @@
 #' @param param
 #' The downsampling parameter. For the "proportional" method, this is the
 #' proportion to retain and should be a numeric value between 0 and 1. For the
-#' exact method, this is the total number of lines to read in.
+#' exact method, this is the total number of lines to read in. For the
+#' "systematic" method, this is the sampling interval (see
+#' \code{file_sample_systematic()}). For the "block" method, this is the
+#' proportion of blocks to retain (see \code{file_sample_block()}). For the
+#' "hash" method, this is the proportion to retain, chosen by hashing each line
+#' (see \code{file_sample_hash()}).
 #' @param method
 #' A string indicating the type of read method to use. Options are
-#' "proportional" and "exact".
+#' "proportional", "exact", "systematic", "block", and "hash".
 #' @param reader
 #' A function specifying the reader to use. The default is 
 #' \code{utils::read.csv}. Other options include \code{data.table::fread()} and
 #' \code{readr::read_csv()}.  Note the first argument of the reader should be
 #' the file to read in and the second should be the the
 #' \code{header}/\code{col_names} argument.  This would require writing a small
-#' wrapper for \code{fread()}.
+#' wrapper for \code{fread()}.  If \code{NULL}, the sample is parsed in
+#' compiled code; see the details section.
 #' @param header
 #' Is a header (line of column names) on the first line of the csv file?
 #' @param nskip
 #' Number of lines to skip. If \code{header=TRUE}, then this only applies to
 #' lines after the header.
 #' @param nmax
-#' Max number of lines to read. If nmax==0, then there is no read cap. Ignored
-#' if \code{method="exact"}.
+#' Max number of lines to read. If nmax==0, then there is no read cap. Only
+#' used if \code{method="proportional"}.
 #' @param verbose
 #' Should linecounts of the input file and the number of lines sampled be
 #' printed?
@@ -66,8 +84,41 @@
 #' @export
 sample_csv = function(file, param, method="proportional", reader=utils::read.csv, header=TRUE, nskip=0, nmax=0, verbose=FALSE, ...)
 {
-  check.is.function(reader)
-  method = match.arg(tolower(method), c("proportional", "exact"))
+  native = is.null(reader)
+  if (!native)
+    check.is.function(reader)
+  
+  method = match.arg(tolower(method), c("proportional", "exact", "systematic", "block", "hash"))
+  
+  if (native)
+  {
+    sep = list(...)$sep
+    if (is.null(sep))
+      sep = ","
+    
+    check.is.string(sep)
+    if (nchar(sep) != 1)
+      stop("argument 'sep' must be a single character")
+  }
+  
+  if (native && method == "proportional")
+  {
+    p = param
+    check.is.scalar(p)
+    check.is.string(file)
+    file = abspath(file)
+    check.is.flag(header)
+    check.is.natnum(nskip)
+    check.is.natnum(nmax)
+    check.is.flag(verbose)
+    
+    if (p == 0)
+      stop("no lines available for input")
+    if (p < 0 || p > 1)
+      stop("Argument 'p' must be between 0 and 1")
+    
+    return(read_table_native(file, p, header, nskip, nmax, sep, verbose))
+  }
   
   outfile = tempfile()
   
@@ -81,10 +132,27 @@ sample_csv = function(file, param, method="proportional", reader=utils::read.csv
     nlines = param
     file_sample_exact(nlines=nlines, infile=file, outfile=outfile, header=header, nskip=nskip, verbose=verbose)
   }
+  else if (method == "systematic")
+  {
+    k = param
+    file_sample_systematic(k=k, infile=file, outfile=outfile, header=header, nskip=nskip, verbose=verbose)
+  }
+  else if (method == "block")
+  {
+    p = param
+    file_sample_block(p=p, infile=file, outfile=outfile, header=header, verbose=verbose)
+  }
+  else if (method == "hash")
+  {
+    p = param
+    file_sample_hash(p=p, infile=file, outfile=outfile, header=header, verbose=verbose)
+  }
   
   
   reader_nm = deparse(substitute(reader))
-  if (grepl(reader_nm, pattern="read_csv"))
+  if (native)
+    data = read_table_native(outfile, 1, header, 0, 0, sep, FALSE)
+  else if (grepl(reader_nm, pattern="read_csv"))
     data = reader(outfile, col_names=header, ...)
   else
     data = reader(outfile, header=header, ...)
@@ -92,3 +160,20 @@ sample_csv = function(file, param, method="proportional", reader=utils::read.csv
   unlink(outfile)
   return(data)
 }
+
+
+
+# sample (p < 1) or read a delimited file into a data.frame in compiled code
+read_table_native = function(file, p, header, nskip, nmax, sep, verbose)
+{
+  ret = .Call(R_fs_sample_table, as.integer(verbose), as.integer(header), as.integer(nskip), as.integer(nmax), as.double(p), sep, file)
+  cols = ret[[2]]
+  
+  if (is.null(ret[[1]]))
+    names(cols) = paste0("V", seq_along(cols))
+  else
+    names(cols) = make.names(ret[[1]], unique=TRUE)
+  
+  nrows = if (length(cols) > 0) length(cols[[1]]) else 0L
+  structure(cols, class="data.frame", row.names=.set_row_names(nrows))
+}
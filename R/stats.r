@@ -0,0 +1,32 @@
+#' @title Print \code{fs_stats} objects
+#' @description
+#' Printing for the instrumentation returned by \code{file_sample_exact()} and
+#' \code{file_sample_prop()}.  Shows the wall time of each phase (line
+#' counting, index generation, sorting, the sampling pass, and writing), the
+#' number of bytes/lines read and written along with the number of read/write
+#' requests made to the operating system, the read throughput, and the line
+#' counting kernel and I/O backend in use.
+#' @param x \code{fs_stats} object
+#' @param ... unused
+#' @name print-fs_stats
+#' @rdname print-fs_stats
+#' @method print fs_stats
+#' @export
+print.fs_stats = function(x, ...)
+{
+  times = c(count=x$time_count, index=x$time_index, sort=x$time_sort, sample=x$time_sample, write=x$time_write)
+  total = sum(times)
+  mbps = if (total > 0) x$bytes_read/1e6/total else 0
+  
+  cat("## Time (seconds)\n")
+  cat(paste0(format(paste0(c(names(times), "total"), ":")), " ", sprintf("%.4f", c(times, total)), collapse="\n"), "\n")
+  cat("## I/O\n")
+  cat(sprintf("read:    %.0f bytes, %.0f lines, %.0f calls (%.2f MB/s)\n", x$bytes_read, x$lines_read, x$nreads, mbps))
+  cat(sprintf("written: %.0f bytes, %.0f lines, %.0f calls\n", x$bytes_written, x$lines_written, x$nwrites))
+  cat("kernel: ", x$kernel, "\n")
+  cat("backend:", x$backend, "\n")
+  if (!is.null(x$coverage))
+    cat(sprintf("coverage: %.2f%% of the file (stopped: %s)\n", 100*x$coverage, x$stopped))
+  
+  invisible()
+}
@@ -8,3 +8,40 @@ abspath = function(file)
   
   p
 }
+
+
+
+# FS_FORMAT_* code of a sampler's output format
+output_format = function(format)
+{
+  check.is.string(format)
+  formats = c("text", "offsets")
+  format = match.arg(tolower(format), formats)
+  
+  match(format, formats) - 1L
+}
+
+
+
+# column number of a key given by number or by header name; 0 is the whole line
+key_index = function(key, file, sep, header)
+{
+  if (is.character(key))
+  {
+    if (!header)
+      stop("argument 'key' can only be a column name if header=TRUE")
+    
+    names = strsplit(readLines(file, n=1), sep, fixed=TRUE)[[1]]
+    names = gsub('^"|"$', "", names)
+    k = match(key, names)
+    if (is.na(k))
+      stop(paste0("column '", key, "' not found in the header"))
+    
+    k
+  }
+  else
+  {
+    check.is.natnum(key)
+    key
+  }
+}
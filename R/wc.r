@@ -7,14 +7,32 @@
 #' in the terminal. Likewise \code{wc_w()} is analogous to \code{wc -w} for
 #' words.
 #' 
+#' With a \code{state} file, \code{wc_l()} counts incrementally: the file is
+#' remembered (its size, line count, and a hash of its start) and the next call
+#' with the same state only reads the bytes appended since.  This is meant for
+#' append-only files such as logs.  If the file was truncated or replaced, the
+#' count starts over.
+#' 
+#' \code{wc_many()} counts many files at once, in parallel (see
+#' \code{\link{set_threads}}).  Large files are split into pieces, and the
+#' pieces of all of the files are shared out among the threads largest first,
+#' so a few large files among many small ones don't leave threads idle.
+#' 
 #' @param file
 #' Location of the file (as a string) from which the counts will be generated.
 #' @param chars,words,lines
 #' Should char/word/line counts be shown? At least one of the three must be
 #' \code{TRUE}.
+#' @param files
+#' Locations of the files (as a character vector) for \code{wc_many()}.
+#' @param state
+#' Optional location of a state file (as a string) for incremental counts.  It
+#' is created if it doesn't exist.
 #' 
 #' @return
-#' A list containing the requested counts.
+#' A list containing the requested counts.  For \code{wc_many()}, a data.frame
+#' with a row per file and a column for the file and for each of the requested
+#' counts.
 #' 
 #' @examples
 #' library(filesampler)
@@ -61,11 +79,48 @@ wc_w = function(file)
 
 
 
+#' @useDynLib filesampler R_fs_wc_incremental
 #' @rdname wc
 #' @export
-wc_l = function(file)
+wc_l = function(file, state=NULL)
 {
-  wc(file=file, chars=FALSE, words=FALSE, lines=TRUE)
+  if (is.null(state))
+    return(wc(file=file, chars=FALSE, words=FALSE, lines=TRUE))
+  
+  check.is.string(file)
+  check.is.string(state)
+  
+  file = abspath(file)
+  ret = .Call(R_fs_wc_incremental, file, path.expand(state))
+  
+  counts = list(chars=ret[1L], words=ret[2L], lines=ret[3L])
+  class(counts) = "wc"
+  attr(counts, "file") = file
+  
+  counts
+}
+
+
+
+#' @useDynLib filesampler R_fs_wc_many
+#' @rdname wc
+#' @export
+wc_many = function(files, chars=TRUE, words=TRUE, lines=TRUE)
+{
+  if (!is.character(files) || anyNA(files))
+    stop("argument 'files' must be a character vector")
+  check.is.flag(chars)
+  check.is.flag(words)
+  check.is.flag(lines)
+  
+  if (!chars && !words && !lines)
+    stop("at least one of the arguments 'chars', 'words', or 'lines' must be TRUE")
+  
+  files = vapply(files, abspath, "", USE.NAMES=FALSE)
+  ret = .Call(R_fs_wc_many, files, chars, words, lines)
+  
+  counts = data.frame(file=files, chars=ret[, 1L], words=ret[, 2L], lines=ret[, 3L], stringsAsFactors=FALSE)
+  counts[, c(TRUE, chars, words, lines)]
 }
 
 
@@ -0,0 +1,46 @@
+#' Fields per Line
+#' 
+#' Count the fields of every line of a file, to check that it is rectangular
+#' before reading or sampling it.
+#' 
+#' @details
+#' The file is scanned once, at about the speed of \code{line_lengths()}, and
+#' each line is split on \code{sep}.  The first line (the header of a csv) is
+#' the reference: every other line with a different number of fields is
+#' ragged.  The total number of ragged lines is counted, and the first few of
+#' them are reported.
+#' 
+#' Quoting is ignored, so a separator inside a quoted field counts as
+#' splitting it.  An empty line has one field.
+#' 
+#' @param file
+#' Location of the file (as a string).
+#' @param sep
+#' The field separator; a single character.
+#' 
+#' @return
+#' A list with the number of \code{lines}, the number of \code{fields} of the
+#' first line, the \code{min} and \code{max} fields of any line, the number of
+#' ragged lines \code{nragged}, and the line numbers (from 1) of the first of
+#' them, \code{ragged}.
+#' 
+#' @examples
+#' library(filesampler)
+#' file = system.file("rawdata/small.csv", package="filesampler")
+#' wc_fields(file)
+#' 
+#' @useDynLib filesampler R_fs_wc_fields
+#' @export
+wc_fields = function(file, sep=",")
+{
+  check.is.string(file)
+  check.is.string(sep)
+  if (nchar(sep) != 1 || sep == "\n")
+    stop("argument 'sep' must be a single character other than a newline")
+  
+  file = abspath(file)
+  
+  ret = .Call(R_fs_wc_fields, file, sep)
+  
+  list(lines=ret[1L], fields=ret[3L], min=ret[4L], max=ret[5L], nragged=ret[6L], ragged=ret[-(1:6)])
+}
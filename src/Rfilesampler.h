@@ -5,9 +5,14 @@
 #include <R.h>
 #include <Rinternals.h>
 
+#include "filesampler/filesampler.h"
+
 #define CHARPT(x,i) ((char*)CHAR(STRING_ELT(x,i)))
 #define INT(x) INTEGER(x)[0]
 #define DBL(x) REAL(x)[0]
 
+// stats.c
+SEXP fs_stats_to_R(const fs_stats_t *stats);
+
 
 #endif
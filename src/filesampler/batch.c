@@ -0,0 +1,546 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filesampler.h"
+#include "gather.h"
+#include "reader.h"
+#include "safeomp.h"
+#include "sampler.h"
+#include "seqindex.h"
+#include "threads.h"
+#include "timer.h"
+#include "utils.h"
+
+
+// Index sets and results of one input of the batch
+typedef struct batchfile_t
+{
+  uint64_t ndata;
+  // sorted post-header line numbers of each request's sample
+  uint64_t **samp;
+  uint64_t *nsamp;
+  // block index of the line count; see fs_wc_checkpoints()
+  uint64_t *checkpoints;
+  uint64_t ncheckpoints;
+  fs_stats_t stats;
+  int ret;
+} batchfile_t;
+
+
+
+static int comp(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t*)a;
+  const uint64_t y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+
+
+static void stats_add(fs_stats_t *stats, const fs_stats_t *s)
+{
+  stats->time_count += s->time_count;
+  stats->time_index += s->time_index;
+  stats->time_sort += s->time_sort;
+  stats->time_sample += s->time_sample;
+  stats->time_write += s->time_write;
+  stats->bytes_read += s->bytes_read;
+  stats->bytes_written += s->bytes_written;
+  stats->lines_read += s->lines_read;
+  stats->lines_written += s->lines_written;
+  stats->nreads += s->nreads;
+  stats->nwrites += s->nwrites;
+  
+  if (s->kernel)
+    stats->kernel = s->kernel;
+  if (s->backend)
+    stats->backend = s->backend;
+}
+
+
+
+// ------------------------------------------------------
+// index sets
+// ------------------------------------------------------
+
+// Independent samples: each is drawn in order on its own
+static int index_independent(const fs_batch_t *b, batchfile_t *f)
+{
+  for (int i=0; i<b->nreq; i++)
+  {
+    seqindex_t seq;
+    const uint64_t n = (b->nlines_out[i] < f->ndata) ? b->nlines_out[i] : f->ndata;
+    
+    f->samp[i] = malloc((n > 0 ? n : 1) * sizeof(**f->samp));
+    if (f->samp[i] == NULL)
+      return MALLOC_FAIL;
+    
+    seqindex_init(&seq, 0, f->ndata, n);
+    f->nsamp[i] = seqindex_fill(&seq, f->samp[i], n);
+  }
+  
+  return 0;
+}
+
+
+
+// Nested samples: a random ordering of the largest sample, of which each
+// request takes a prefix, so every sample is contained in the larger ones
+static int index_nested(const fs_batch_t *b, batchfile_t *f, fs_stats_t *stats)
+{
+  seqindex_t seq;
+  uint64_t *pool;
+  uint64_t m = 0;
+  double start;
+  
+  for (int i=0; i<b->nreq; i++)
+  {
+    if (b->nlines_out[i] > m)
+      m = b->nlines_out[i];
+  }
+  
+  if (m > f->ndata)
+    m = f->ndata;
+  
+  pool = malloc((m > 0 ? m : 1) * sizeof(*pool));
+  if (pool == NULL)
+    return MALLOC_FAIL;
+  
+  seqindex_init(&seq, 0, f->ndata, m);
+  seqindex_fill(&seq, pool, m);
+  
+  for (uint64_t j=m; j>1; j--)
+  {
+    uint64_t k = (uint64_t) (j*RUNIF);
+    uint64_t tmp = pool[j-1];
+    pool[j-1] = pool[k];
+    pool[k] = tmp;
+  }
+  
+  for (int i=0; i<b->nreq; i++)
+  {
+    const uint64_t n = (b->nlines_out[i] < m) ? b->nlines_out[i] : m;
+    
+    f->samp[i] = malloc((n > 0 ? n : 1) * sizeof(**f->samp));
+    if (f->samp[i] == NULL)
+    {
+      free(pool);
+      return MALLOC_FAIL;
+    }
+    
+    memcpy(f->samp[i], pool, n * sizeof(*pool));
+    f->nsamp[i] = n;
+    
+    start = fs_timer_now();
+    qsort(f->samp[i], n, sizeof(**f->samp), comp);
+    if (stats)
+      stats->time_sort += fs_timer_now() - start;
+  }
+  
+  free(pool);
+  return 0;
+}
+
+
+
+// ------------------------------------------------------
+// merged scan
+// ------------------------------------------------------
+
+// The outputs of the requests whose next sampled line is `line`, moving
+// their cursors past it; next is set to the smallest pending line.
+static int batch_targets(const int nreq, const batchfile_t *f, const uint64_t line, uint64_t *pos, FILE **fp_write, FILE **targets, uint64_t *next)
+{
+  int ntargets = 0;
+  
+  *next = UINT64_MAX;
+  for (int i=0; i<nreq; i++)
+  {
+    if (pos[i] < f->nsamp[i] && f->samp[i][pos[i]] == line)
+    {
+      targets[ntargets++] = fp_write[i];
+      pos[i]++;
+    }
+    
+    if (pos[i] < f->nsamp[i] && f->samp[i][pos[i]] < *next)
+      *next = f->samp[i][pos[i]];
+  }
+  
+  return ntargets;
+}
+
+
+
+// sequential pass, reading every line up to the last sampled one
+static int batch_read(reader_t *r, const int nreq, const bool header, const bool interrupts, batchfile_t *f, uint64_t *pos, FILE **fp_write, FILE **targets, uint64_t next, uint64_t *nlines_in, uint64_t *nlines_total)
+{
+  int ret = 0;
+  char *line;
+  size_t len;
+  uint64_t current_line = 0;
+  
+  if (header)
+  {
+    ret = reader_line(r, &line, &len);
+    if (ret < 0)
+      return ret;
+    
+    if (ret)
+    {
+      for (int i=0; i<nreq; i++)
+        write_buf(line, len, fp_write[i], &f->stats);
+      
+      (*nlines_in)++;
+      *nlines_total += nreq;
+    }
+  }
+  
+  while (next != UINT64_MAX && (ret = reader_line(r, &line, &len)) > 0)
+  {
+    if (interrupts && (current_line % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      return USER_INTERRUPT;
+    
+    (*nlines_in)++;
+    
+    if (current_line == next)
+    {
+      const int ntargets = batch_targets(nreq, f, current_line, pos, fp_write, targets, &next);
+      for (int i=0; i<ntargets; i++)
+        write_buf(line, len, targets[i], &f->stats);
+      
+      *nlines_total += ntargets;
+    }
+    
+    current_line++;
+  }
+  
+  return (ret < 0) ? ret : 0;
+}
+
+
+
+// gather pass, reading only the blocks holding sampled lines
+static int batch_gather(gather_t *g, const int nreq, const bool header, const bool interrupts, batchfile_t *f, uint64_t *pos, FILE **fp_write, FILE **targets, uint64_t next, uint64_t *nlines_total)
+{
+  int ret;
+  uint64_t n = 0;
+  
+  if (header)
+  {
+    ret = gather_line_n(g, 0, fp_write, nreq, &f->stats);
+    if (ret < 0)
+      return ret;
+    
+    *nlines_total += ret*nreq;
+  }
+  
+  while (next != UINT64_MAX)
+  {
+    const uint64_t line = next;
+    int ntargets;
+    
+    if (interrupts && (n++ % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      return USER_INTERRUPT;
+    
+    ntargets = batch_targets(nreq, f, line, pos, fp_write, targets, &next);
+    ret = gather_line_n(g, line + header, targets, ntargets, &f->stats);
+    if (ret <= 0)
+      return ret;
+    
+    *nlines_total += ntargets;
+  }
+  
+  return 0;
+}
+
+
+
+// One pass over the input, writing each line to every request whose next
+// sampled line it is.  If the samples are sparse next to the blocks of the
+// file, only the blocks holding them are read, found from the checkpoints
+// of the line count.  Interrupts are only checked from the main thread.
+static int batch_scan(const fs_batch_t *b, const bool header, const bool interrupts, batchfile_t *f)
+{
+  int ret;
+  reader_t r;
+  gather_t g;
+  bool gather;
+  FILE **fp_write;
+  FILE **targets;
+  uint64_t *pos;
+  uint64_t next = UINT64_MAX;
+  uint64_t nsamp = 0;
+  uint64_t nlines_in = 0;
+  uint64_t nlines_total = 0;
+  const int nreq = b->nreq;
+  const double start = fs_timer_now();
+  const double write_start = f->stats.time_write;
+  
+  for (int i=0; i<nreq; i++)
+    nsamp += f->nsamp[i];
+  
+  gather = (f->checkpoints != NULL && (nsamp + header)*SPARSE_RATIO < f->ncheckpoints);
+  
+  pos = calloc(nreq, sizeof(*pos));
+  fp_write = calloc(nreq, sizeof(*fp_write));
+  targets = calloc(nreq, sizeof(*targets));
+  if (pos == NULL || fp_write == NULL || targets == NULL)
+  {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  if (gather)
+    ret = gather_open(&g, b->input, f->checkpoints, f->ncheckpoints);
+  else
+    ret = reader_open(&r, b->input);
+  
+  if (ret)
+    goto cleanup;
+  
+  for (int i=0; i<nreq; i++)
+  {
+    fp_write[i] = fopen(b->outputs[i], "w");
+    if (!fp_write[i])
+    {
+      ret = WRITE_FAIL;
+      goto fullcleanup;
+    }
+    
+    setvbuf(fp_write[i], NULL, _IOFBF, BUFLEN);
+    
+    if (f->nsamp[i] > 0 && f->samp[i][0] < next)
+      next = f->samp[i][0];
+  }
+  
+  if (gather)
+  {
+    ret = batch_gather(&g, nreq, header, interrupts, f, pos, fp_write, targets, next, &nlines_total);
+    if (!ret)
+      finalize_stats_n(g.bytes, g.nreads, "pread", fp_write, nreq, start, write_start, g.nlines, nlines_total, &f->stats);
+  }
+  else
+  {
+    ret = batch_read(&r, nreq, header, interrupts, f, pos, fp_write, targets, next, &nlines_in, &nlines_total);
+    if (!ret)
+      finalize_stats_n(r.bytes, r.nreads, reader_backend_name(&r), fp_write, nreq, start, write_start, nlines_in, nlines_total, &f->stats);
+  }
+  
+  
+  fullcleanup:
+    if (gather)
+      gather_close(&g);
+    else
+      reader_close(&r);
+    
+    for (int i=0; i<nreq; i++)
+    {
+      if (fp_write[i])
+        fclose(fp_write[i]);
+    }
+  
+  cleanup:
+    free(pos);
+    free(fp_write);
+    free(targets);
+  
+  return ret;
+}
+
+
+
+static void batchfile_free(const fs_batch_t *b, batchfile_t *f)
+{
+  if (f->samp)
+  {
+    for (int i=0; i<b->nreq; i++)
+      free(f->samp[i]);
+  }
+  
+  free(f->samp);
+  free(f->nsamp);
+  free(f->checkpoints);
+}
+
+
+
+/**
+ * @file
+ * @brief 
+ * Batch File Sampler (Exact)
+ *
+ * @details
+ * This function draws several exact samples (as with fs_sample_exact())
+ * from each of several input files, reading each input only twice:
+ * once to count its lines, and once for a single scan that writes
+ * every sample at the same time.  If the samples of a file are sparse
+ * next to its blocks, the second pass reads only the blocks holding
+ * sampled lines, as fs_sample_exact() does.  Each request keeps a
+ * cursor into its own sorted index, and each line is matched against
+ * the smallest pending line number of all of them.
+ * 
+ * With nested=false, the samples of a file are drawn independently.
+ * With nested=true, a random ordering of the largest sample is drawn,
+ * and each sample is a prefix of it; so each is still a simple random
+ * sample, and every sample is contained in the larger ones.
+ * 
+ * All of the index sets are drawn from the RNG up front by the calling
+ * thread, so memory use is proportional to the total size of the
+ * samples.  The scans of different files then run on up to max_reads
+ * threads (see also fs_set_nthreads()), each reading one file.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not the inputs have a header line (as
+ * in a csv).  If so, it is written to every output.
+ * @param nested
+ * Input.  Draw nested rather than independent samples of each file.
+ * @param max_reads
+ * Input.  The most files to read at once; 0 for one per thread.
+ * @param nfiles
+ * Input.  Number of input files.
+ * @param batch
+ * Input.  Array of length nfiles; the input file and the sample sizes
+ * and output files requested of it.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * of all the files are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_exact_batch(const bool verbose, const bool header, const bool nested, const int max_reads, const int nfiles, const fs_batch_t *batch, fs_stats_t *stats)
+{
+  int ret = 0;
+  int nworkers;
+  batchfile_t *files;
+  
+  if (nfiles < 1)
+    return 0;
+  
+  files = calloc(nfiles, sizeof(*files));
+  if (files == NULL)
+    return MALLOC_FAIL;
+  
+  // count each file; the counting is itself parallel
+  for (int i=0; i<nfiles && !ret; i++)
+  {
+    uint64_t nlines_in;
+    
+    fs_stats_init(&files[i].stats);
+    ret = fs_wc_checkpoints(batch[i].input, &nlines_in, &files[i].checkpoints, &files[i].ncheckpoints, &files[i].stats);
+    if (ret)
+      break;
+    
+    files[i].ndata = nlines_in + last_line_unterminated(batch[i].input);
+    if (header && files[i].ndata > 0)
+      files[i].ndata--;
+    
+    files[i].samp = calloc(batch[i].nreq, sizeof(*files[i].samp));
+    files[i].nsamp = calloc(batch[i].nreq, sizeof(*files[i].nsamp));
+    if (files[i].samp == NULL || files[i].nsamp == NULL)
+      ret = MALLOC_FAIL;
+  }
+  
+  if (ret)
+    goto cleanup;
+  
+  STARTRNG;
+  
+  for (int i=0; i<nfiles && !ret; i++)
+  {
+    const double start = fs_timer_now();
+    
+    if (nested)
+      ret = index_nested(&batch[i], &files[i], &files[i].stats);
+    else
+      ret = index_independent(&batch[i], &files[i]);
+    
+    files[i].stats.time_index += fs_timer_now() - start - files[i].stats.time_sort;
+  }
+  
+  ENDRNG;
+  
+  if (ret)
+    goto cleanup;
+  
+  nworkers = fs_get_nthreads();
+  if (max_reads > 0 && max_reads < nworkers)
+    nworkers = max_reads;
+  if (nfiles < nworkers)
+    nworkers = nfiles;
+  
+  // the workers don't check for interrupts, so the files are scanned in
+  // rounds of nworkers with a check between them
+  for (int f0=0; f0<nfiles; f0+=nworkers)
+  {
+    const int f1 = (f0 + nworkers < nfiles) ? f0 + nworkers : nfiles;
+    
+    if (check_interrupt())
+    {
+      for (int i=f0; i<nfiles; i++)
+        files[i].ret = USER_INTERRUPT;
+      
+      break;
+    }
+    
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(nworkers) schedule(dynamic,1) if(nworkers > 1)
+    #endif
+    for (int i=f0; i<f1; i++)
+      files[i].ret = batch_scan(&batch[i], header, (nworkers == 1), &files[i]);
+  }
+  
+  for (int i=0; i<nfiles; i++)
+  {
+    if (files[i].ret && !ret)
+      ret = files[i].ret;
+    
+    if (stats)
+      stats_add(stats, &files[i].stats);
+    
+    if (verbose && !files[i].ret)
+      PRINTFUN("Wrote %d samples of %llu line file %s.\n", batch[i].nreq, files[i].ndata, batch[i].input);
+  }
+  
+  
+  cleanup:
+    for (int i=0; i<nfiles; i++)
+      batchfile_free(&batch[i], &files[i]);
+    
+    free(files);
+  
+  return ret;
+}
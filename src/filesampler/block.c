@@ -0,0 +1,519 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+#include "writer.h"
+
+// Blocks visited by fs_sample_anytime() between interrupt checks
+#define ANYTIME_CHECK_NUM 16
+
+
+typedef struct region_t
+{
+  int fd;
+  char *buf;
+  uint64_t filesize;
+  uint64_t nreads;
+  uint64_t bytes;
+  // set when a region ends in a last line without a newline
+  bool unterminated;
+} region_t;
+
+
+
+static int region_open(region_t *g, const char *input)
+{
+  struct stat sb;
+  
+  g->fd = open(input, O_RDONLY);
+  if (g->fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(g->fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(g->fd);
+    return READ_FAIL;
+  }
+  
+  g->filesize = (uint64_t) sb.st_size;
+  g->nreads = 0;
+  g->bytes = 0;
+  g->unterminated = false;
+  g->buf = malloc(FS_BLOCKLEN);
+  if (g->buf == NULL)
+  {
+    close(g->fd);
+    return MALLOC_FAIL;
+  }
+  
+  return 0;
+}
+
+
+
+static void region_close(region_t *g)
+{
+  close(g->fd);
+  free(g->buf);
+}
+
+
+
+// Write the lines that start in [lo, hi).  The region is read with pread()
+// from lo-1 (to tell whether lo starts a line) and past hi only as far as
+// needed to finish the last line.  Neighbouring retained blocks make one run
+// for the writer.
+static int region_lines(region_t *g, const uint64_t lo, const uint64_t hi, writer_t *w, uint64_t *nlines_out, fs_stats_t *stats)
+{
+  uint64_t offset = (lo > 0) ? lo - 1 : 0;
+  // looking for the first line start
+  bool seeking = (lo > 0);
+  bool writing = false;
+  
+  while (offset < g->filesize)
+  {
+    size_t len;
+    size_t pos = 0;
+    
+    if (offset < hi)
+      len = (hi - offset > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (hi - offset);
+    else
+      len = BUFLEN;
+    
+    if (len > g->filesize - offset)
+      len = (size_t) (g->filesize - offset);
+    
+    if (pread_full(g->fd, g->buf, len, offset, &g->nreads))
+      return READ_FAIL;
+    
+    g->bytes += len;
+    
+    while (pos < len)
+    {
+      char *start = g->buf + pos;
+      char *nl = memchr(start, '\n', len - pos);
+      size_t n = nl ? (size_t) (nl - start + 1) : len - pos;
+      
+      if (seeking)
+      {
+        if (nl)
+          seeking = false;
+      }
+      else
+      {
+        if (!writing)
+        {
+          if (offset + pos >= hi)
+            return 0;
+          
+          writing = true;
+        }
+        
+        int ret = writer_range(w, start, n, offset + pos, stats);
+        if (ret)
+          return ret;
+        
+        if (nl)
+        {
+          writing = false;
+          (*nlines_out)++;
+        }
+      }
+      
+      pos += n;
+    }
+    
+    offset += len;
+    if (!writing && offset >= hi)
+      return 0;
+  }
+  
+  // last line of the file had no trailing newline
+  if (writing)
+  {
+    (*nlines_out)++;
+    g->unterminated = true;
+  }
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief 
+ * Block File Sampler
+ *
+ * @details
+ * This function splits the input file into contiguous blocks of
+ * `blocksize` bytes, randomly retains each block with probability p,
+ * and writes out the lines starting in the retained blocks.  Only
+ * the retained blocks are read (with pread()), so the amount of I/O
+ * shrinks with p, unlike the proportional sampler which has to read
+ * every line to choose among them.
+ * 
+ * Each line belongs to exactly one block (the one holding its first
+ * byte), so each line is retained with probability p.  However, the
+ * lines are retained in clusters, which makes this a cluster sample
+ * rather than a simple random sample: if nearby lines are similar,
+ * estimates from it are less precise than from a line-level sample
+ * of the same size.
+ *
+ * @param verbose
+ * Input.  Indicates whether block/line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).
+ * @param p
+ * Input.  Proportion of blocks to (randomly) retain.
+ * @param blocksize
+ * Input.  Size of the blocks in bytes; must be positive.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_block(const bool verbose, const bool header, const double p, const uint64_t blocksize, const char *input, const char *output, fs_stats_t *stats)
+{
+  int ret = 0;
+  region_t g;
+  writer_t w;
+  FILE *fp_write;
+  uint64_t first = 0;
+  uint64_t nblocks;
+  uint64_t nblocks_out = 0;
+  uint64_t nlines_out = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  if (p < 0. || p > 1.)
+    return INVALID_PROB;
+  if (blocksize == 0)
+    return INVALID_BLOCKSIZE;
+  
+  ret = region_open(&g, input);
+  if (ret)
+    return ret;
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    ret = WRITE_FAIL;
+    goto cleanup;
+  }
+  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  ret = writer_open(&w, fp_write, input);
+  if (ret)
+    goto cleanup;
+  
+  // the header is the line starting at 0, and is excluded from the blocks
+  if (header)
+  {
+    ret = region_lines(&g, 0, 1, &w, &nlines_out, stats);
+    if (ret)
+      goto cleanup;
+    
+    first = w.nbytes;
+  }
+  
+  nblocks = (g.filesize + blocksize - 1) / blocksize;
+  
+  STARTRNG;
+  
+  for (uint64_t b=0; b<nblocks; b++)
+  {
+    uint64_t lo = b*blocksize;
+    uint64_t hi = lo + blocksize;
+    
+    if ((b % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    if (RUNIF >= p)
+      continue;
+    
+    nblocks_out++;
+    if (lo < first)
+      lo = first;
+    if (lo >= hi)
+      continue;
+    
+    ret = region_lines(&g, lo, hi, &w, &nlines_out, stats);
+    if (ret)
+      break;
+  }
+  
+  ENDRNG;
+  
+  if (!ret)
+    ret = writer_flush(&w, stats);
+  if (ret)
+    goto cleanup;
+  
+  finalize_stats(g.bytes, g.nreads, "pread", fp_write, start, write_start, nlines_out, nlines_out, stats);
+  writer_stats(&w, stats);
+  
+  if (verbose)
+    PRINTFUN("Read %llu lines from %llu of %llu blocks (%.5f%% of the file).\n", nlines_out, nblocks_out, nblocks, 100.*g.bytes/g.filesize);
+  
+  
+  cleanup:
+    if (fp_write)
+    {
+      writer_close(&w);
+      fclose(fp_write);
+    }
+    
+    region_close(&g);
+  
+  return ret;
+}
+
+
+
+/**
+ * @file
+ * @brief 
+ * Anytime Block Sampler
+ *
+ * @details
+ * This function visits the blocksize byte blocks of the input file in a
+ * random order, writing out the lines starting in each block as it goes,
+ * until every block has been visited or a budget runs out.  Because the
+ * visited blocks are always a simple random sample of the blocks, the
+ * output is a valid cluster sample (see fs_sample_block()) whenever the
+ * function stops, and gets larger the longer it is allowed to run.
+ * 
+ * A user interrupt ends the run like a budget does, with the lines
+ * written so far, rather than with an error.  The blocks appear in the
+ * output in the order they were visited, so unlike the other samplers
+ * the lines are not in file order (except within a block), and a last
+ * line without a newline is given one.
+ *
+ * @param verbose
+ * Input.  Indicates whether block/line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).
+ * @param blocksize
+ * Input.  Size of the blocks in bytes; must be positive.
+ * @param time_limit
+ * Input.  Stop after this many seconds; 0 for no limit.
+ * @param byte_limit
+ * Input.  Stop once this many bytes have been read; 0 for no limit.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param coverage
+ * Output, passed by reference.  The fraction of the file's bytes in the
+ * visited blocks.
+ * @param stopped
+ * Output, passed by reference.  Why the run ended; one of the FS_STOP_*
+ * values.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_anytime(const bool verbose, const bool header, const uint64_t blocksize, const double time_limit, const uint64_t byte_limit, const char *input, const char *output, double *coverage, int *stopped, fs_stats_t *stats)
+{
+  int ret = 0;
+  region_t g;
+  writer_t w;
+  FILE *fp_write;
+  uint64_t *order = NULL;
+  uint64_t first = 0;
+  uint64_t nblocks;
+  uint64_t nvisited = 0;
+  uint64_t bytes_covered = 0;
+  uint64_t nlines_out = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  *coverage = 0.;
+  *stopped = FS_STOP_DONE;
+  
+  if (blocksize == 0)
+    return INVALID_BLOCKSIZE;
+  
+  ret = region_open(&g, input);
+  if (ret)
+    return ret;
+  
+  nblocks = (g.filesize + blocksize - 1) / blocksize;
+  if (nblocks > 0)
+  {
+    order = malloc(nblocks * sizeof(*order));
+    if (order == NULL)
+    {
+      region_close(&g);
+      return MALLOC_FAIL;
+    }
+    
+    for (uint64_t b=0; b<nblocks; b++)
+      order[b] = b;
+  }
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    ret = WRITE_FAIL;
+    goto cleanup;
+  }
+  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  ret = writer_open(&w, fp_write, input);
+  if (ret)
+    goto cleanup;
+  
+  if (header)
+  {
+    ret = region_lines(&g, 0, 1, &w, &nlines_out, stats);
+    if (ret)
+      goto cleanup;
+    
+    first = w.nbytes;
+  }
+  
+  STARTRNG;
+  
+  // Fisher-Yates, one step per visited block
+  for (uint64_t i=0; i<nblocks; i++)
+  {
+    if (time_limit > 0. && fs_timer_now() - start >= time_limit)
+    {
+      *stopped = FS_STOP_TIME;
+      break;
+    }
+    
+    if (byte_limit > 0 && g.bytes >= byte_limit)
+    {
+      *stopped = FS_STOP_BYTES;
+      break;
+    }
+    
+    if ((i % ANYTIME_CHECK_NUM == 0) && check_interrupt())
+    {
+      *stopped = FS_STOP_INTERRUPT;
+      break;
+    }
+    
+    uint64_t j = i + (uint64_t) ((nblocks - i)*RUNIF);
+    if (j >= nblocks)
+      j = nblocks - 1;
+    
+    const uint64_t b = order[j];
+    order[j] = order[i];
+    order[i] = b;
+    
+    uint64_t lo = b*blocksize;
+    uint64_t hi = lo + blocksize;
+    
+    nvisited++;
+    bytes_covered += ((hi > g.filesize) ? g.filesize : hi) - lo;
+    
+    if (lo < first)
+      lo = first;
+    if (lo >= hi)
+      continue;
+    
+    ret = region_lines(&g, lo, hi, &w, &nlines_out, stats);
+    if (ret)
+      break;
+    
+    // other blocks may follow the last line of the file
+    if (g.unterminated)
+    {
+      g.unterminated = false;
+      ret = writer_flush(&w, stats);
+      if (ret)
+        break;
+      
+      write_buf("\n", 1, fp_write, stats);
+    }
+  }
+  
+  ENDRNG;
+  
+  if (!ret)
+    ret = writer_flush(&w, stats);
+  if (ret)
+    goto cleanup;
+  
+  *coverage = (g.filesize > 0) ? (double) bytes_covered / g.filesize : 1.;
+  
+  finalize_stats(g.bytes, g.nreads, "pread", fp_write, start, write_start, nlines_out, nlines_out, stats);
+  writer_stats(&w, stats);
+  
+  if (verbose)
+    PRINTFUN("Read %llu lines from %llu of %llu blocks (%.5f%% of the file).\n", nlines_out, nvisited, nblocks, 100.*(*coverage));
+  
+  
+  cleanup:
+    if (fp_write)
+    {
+      writer_close(&w);
+      fclose(fp_write);
+    }
+    
+    region_close(&g);
+    free(order);
+  
+  return ret;
+}
@@ -0,0 +1,321 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+
+
+// A range of post-header line numbers [lo, hi) and the number of draws that
+// fall in it
+typedef struct split_t
+{
+  uint64_t lo;
+  uint64_t hi;
+  uint64_t m;
+} split_t;
+
+// At most one range is pushed per halving, so 64 halvings of a 64-bit line
+// count and the root
+#define SPLIT_DEPTH 66
+
+// The counts of one replicate, in line order: the next line drawn and how
+// many times it was drawn
+typedef struct resample_t
+{
+  split_t stack[SPLIT_DEPTH];
+  int top;
+  uint64_t line;
+  uint64_t count;
+} resample_t;
+
+
+
+// Find the next line with a nonzero count.  The draws of a range are split
+// between its halves with a binomial, which is how a multinomial with equal
+// probabilities breaks down, so the counts come out in line order and only
+// the ranges holding draws are visited.
+static void resample_next(resample_t *r)
+{
+  while (r->top > 0)
+  {
+    split_t s = r->stack[--r->top];
+    
+    while (s.hi - s.lo > 1)
+    {
+      const uint64_t mid = s.lo + (s.hi - s.lo)/2;
+      const uint64_t left = (uint64_t) RBINOM((double) s.m, (double) (mid - s.lo) / (double) (s.hi - s.lo));
+      
+      if (left == 0)
+        s.lo = mid;
+      else if (left == s.m)
+        s.hi = mid;
+      else
+      {
+        r->stack[r->top].lo = mid;
+        r->stack[r->top].hi = s.hi;
+        r->stack[r->top].m = s.m - left;
+        r->top++;
+        
+        s.hi = mid;
+        s.m = left;
+      }
+    }
+    
+    r->line = s.lo;
+    r->count = s.m;
+    return;
+  }
+  
+  r->line = UINT64_MAX;
+  r->count = 0;
+}
+
+
+
+static void resample_init(resample_t *r, const uint64_t ndata, const uint64_t n)
+{
+  r->top = 0;
+  if (ndata > 0 && n > 0)
+  {
+    r->stack[0].lo = 0;
+    r->stack[0].hi = ndata;
+    r->stack[0].m = n;
+    r->top = 1;
+  }
+  
+  resample_next(r);
+}
+
+
+
+/**
+ * @file
+ * @brief 
+ * Bootstrap File Sampler
+ *
+ * @details
+ * This function draws nreps samples with replacement (bootstrap
+ * replicates) of nlines_out lines each from an input file, in one scan
+ * of it after the line count.  Each line is written to a replicate as
+ * many times as it was drawn, so each replicate holds nlines_out lines
+ * (after the header), in file order.
+ * 
+ * The counts of the lines in a replicate are multinomial.  Rather than
+ * drawing nlines_out line numbers and sorting them, the draws are
+ * split between the two halves of the range of lines with a binomial,
+ * and so on down, depth first.  So each replicate produces its counts
+ * in line order as the scan reaches them, with only a stack of
+ * O(log(lines)) ranges and O(nlines_out log(lines)) binomial draws,
+ * whatever the sizes.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).  If so, it is written once to every output.
+ * @param nlines_out
+ * Input.  The number of lines in each replicate, at most INT_MAX; 0
+ * for as many as the input has (the usual bootstrap).
+ * @param nreps
+ * Input.  The number of replicates.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param outputs
+ * Input.  Array of nreps absolute paths to the output files.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_bootstrap(const bool verbose, const bool header, uint64_t nlines_out, const int nreps, const char *input, const char **outputs, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  FILE **fp_write;
+  resample_t *reps;
+  char *line;
+  size_t len;
+  uint64_t ndata;
+  uint64_t next = UINT64_MAX;
+  uint64_t current_line = 0;
+  uint64_t nlines_in = 0;
+  uint64_t nlines_total = 0;
+  double start, write_start;
+  
+  if (nreps < 1)
+    return 0;
+  
+  ret = fs_wc(input, false, NULL, false, NULL, true, &ndata, stats);
+  if (ret)
+    return ret;
+  
+  ndata += last_line_unterminated(input);
+  if (header && ndata > 0)
+    ndata--;
+  
+  if (nlines_out == 0)
+    nlines_out = ndata;
+  
+  // the limit of R's rbinom()
+  if (nlines_out > INT_MAX)
+    return INVALID_NLINES;
+  
+  start = fs_timer_now();
+  write_start = stats ? stats->time_write : 0.;
+  
+  reps = malloc(nreps * sizeof(*reps));
+  fp_write = calloc(nreps, sizeof(*fp_write));
+  if (reps == NULL || fp_write == NULL)
+  {
+    free(reps);
+    free(fp_write);
+    return MALLOC_FAIL;
+  }
+  
+  ret = reader_open(&r, input);
+  if (ret)
+  {
+    free(reps);
+    free(fp_write);
+    return ret;
+  }
+  
+  for (int i=0; i<nreps; i++)
+  {
+    fp_write[i] = fopen(outputs[i], "w");
+    if (!fp_write[i])
+    {
+      ret = WRITE_FAIL;
+      goto cleanup;
+    }
+    
+    setvbuf(fp_write[i], NULL, _IOFBF, BUFLEN);
+  }
+  
+  if (header)
+  {
+    ret = reader_line(&r, &line, &len);
+    if (ret < 0)
+      goto cleanup;
+    
+    if (ret)
+    {
+      for (int i=0; i<nreps; i++)
+        write_buf(line, len, fp_write[i], stats);
+      
+      nlines_in++;
+      nlines_total += nreps;
+    }
+  }
+  
+  STARTRNG;
+  
+  for (int i=0; i<nreps; i++)
+  {
+    resample_init(reps + i, ndata, nlines_out);
+    if (reps[i].line < next)
+      next = reps[i].line;
+  }
+  
+  while (next != UINT64_MAX && (ret = reader_line(&r, &line, &len)) > 0)
+  {
+    if ((current_line % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    nlines_in++;
+    
+    if (current_line == next)
+    {
+      // a last line without a newline is given one, so its copies stay
+      // separate lines
+      const bool newline = (len > 0 && line[len-1] == '\n');
+      
+      next = UINT64_MAX;
+      for (int i=0; i<nreps; i++)
+      {
+        if (reps[i].line == current_line)
+        {
+          for (uint64_t c=0; c<reps[i].count; c++)
+          {
+            write_buf(line, len, fp_write[i], stats);
+            if (!newline)
+              write_buf("\n", 1, fp_write[i], stats);
+          }
+          
+          nlines_total += reps[i].count;
+          resample_next(reps + i);
+        }
+        
+        if (reps[i].line < next)
+          next = reps[i].line;
+      }
+    }
+    
+    current_line++;
+  }
+  
+  ENDRNG;
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  ret = 0;
+  finalize_stats_n(r.bytes, r.nreads, reader_backend_name(&r), fp_write, nreps, start, write_start, nlines_in, nlines_total, stats);
+  
+  if (verbose)
+    PRINTFUN("Wrote %d replicates of %llu lines drawn from %llu lines.\n", nreps, nlines_out, ndata);
+  
+  
+  cleanup:
+    reader_close(&r);
+    for (int i=0; i<nreps; i++)
+    {
+      if (fp_write[i])
+        fclose(fp_write[i]);
+    }
+    
+    free(reps);
+    free(fp_write);
+  
+  return ret;
+}
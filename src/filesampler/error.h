@@ -45,6 +45,26 @@
 #define MALLOC_FAIL     -5
 #define USER_INTERRUPT  -6
 
+// More parameter checks
+#define INVALID_INTERVAL  -7
+#define INVALID_BLOCKSIZE -8
+#define INVALID_RANGE     -9
+#define INVALID_RANK      -11
+#define INVALID_NLINES    -12
+
+// Unusable input
+#define TOO_MANY_FIELDS   -10
+#define INVALID_STATE     -13
+
+#define INVALID_INTERVAL_MSG  "Invalid `k` specified. Must be a positive integer."
+#define INVALID_BLOCKSIZE_MSG "Invalid `blocksize` specified. Must be a positive integer."
+#define INVALID_RANGE_MSG     "Invalid line range specified. Must have 1 <= first <= last."
+#define INVALID_RANK_MSG      "Invalid rank specified. Must have 0 <= rank < nranks."
+#define INVALID_NLINES_MSG    "Invalid `nlines` specified. Must be a positive integer."
+
+#define TOO_MANY_FIELDS_MSG   "A sampled line has more fields than the first line."
+#define INVALID_STATE_MSG     "The state file is corrupt, or was made by a different call."
+
 #define READ_FAIL_MSG       "Could not read infile; perhaps it doesn't exist?"
 #define WRITE_FAIL_MSG      "Could not generate tempfile for writing for some reason?"
 #define MALLOC_FAIL_MSG     "Out of memory."
@@ -75,6 +95,27 @@ static inline void fs_checkret(const int ret)
     case USER_INTERRUPT:
       fs_error_fun(ret, USER_INTERRUPT_MSG);
       break;
+    case INVALID_INTERVAL:
+      fs_error_fun(ret, INVALID_INTERVAL_MSG);
+      break;
+    case INVALID_BLOCKSIZE:
+      fs_error_fun(ret, INVALID_BLOCKSIZE_MSG);
+      break;
+    case INVALID_RANGE:
+      fs_error_fun(ret, INVALID_RANGE_MSG);
+      break;
+    case INVALID_RANK:
+      fs_error_fun(ret, INVALID_RANK_MSG);
+      break;
+    case INVALID_NLINES:
+      fs_error_fun(ret, INVALID_NLINES_MSG);
+      break;
+    case INVALID_STATE:
+      fs_error_fun(ret, INVALID_STATE_MSG);
+      break;
+    case TOO_MANY_FIELDS:
+      fs_error_fun(ret, TOO_MANY_FIELDS_MSG);
+      break;
     default:
       fs_error_fun(ret, "Unknown error code; please report this to the developers.");
   }
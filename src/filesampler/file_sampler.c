@@ -25,34 +25,110 @@
 */
 
 
+#include <fcntl.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "filesampler.h"
+#include "gather.h"
+#include "reader.h"
 #include "safeomp.h"
+#include "sampler.h"
+#include "scan.h"
+#include "seqindex.h"
+#include "threads.h"
+#include "timer.h"
 #include "utils.h"
+#include "writer.h"
 
 
-#define HAS_NEWLINE ((readlen > 0) && (buf[readlen-1] == '\n'))
-
-static inline void read_header(char *buf, FILE *fp_read, FILE *fp_write, uint64_t *nlines_in, uint64_t *nlines_out)
+// The sampling pass of fs_sample_prop(), after the header.  nmax is left at
+// 0 if the pass stopped there.
+static int prop_scan(reader_t *r, writer_t *w, FILE *fp_write, const bool offsets, uint32_t nskip, uint32_t *nmax, const double p, uint64_t *nlines_in, uint64_t *nlines_out, fs_stats_t *stats)
 {
+  int ret;
+  char *buf;
   size_t readlen;
+  // Lines straddling two blocks are read in pieces
+  bool should_write = false;
+  bool singleread = true;
+  const bool checkmax = *nmax ? true : false;
+  // the retained line being read, for the offsets output
+  uint64_t line_offset = 0, line_len = 0;
   
-  while (fgets(buf, BUFLEN, fp_read) != NULL)
+  while ((ret = reader_getline(r, &buf, &readlen)) > 0)
   {
-    fprintf(fp_write, "%s", buf);
+    if (singleread)
+    {
+      if ((*nlines_in % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+        return USER_INTERRUPT;
+      
+      if (RUNIF < p)
+        should_write = true;
+      else
+        should_write = false;
+    }
     
-    readlen = strnlen(buf, BUFLEN);
+    if (!nskip && should_write)
+    {
+      if (offsets)
+      {
+        if (singleread)
+        {
+          line_offset = reader_offset(r, buf);
+          line_len = 0;
+        }
+        
+        line_len += readlen;
+      }
+      else
+      {
+        ret = writer_range(w, buf, readlen, reader_offset(r, buf), stats);
+        if (ret)
+          return ret;
+      }
+    }
     
+    // check if more reads for this one line are needed (i.e., it continues in the next block)
     if (HAS_NEWLINE)
     {
       (*nlines_in)++;
-      (*nlines_out)++;
-      break;
+      singleread = true;
+      
+      if (nskip)
+        nskip--;
+      else if (should_write)
+      {
+        (*nlines_out)++;
+        if (offsets)
+          write_offset(*nlines_in - 1, line_offset, line_len, fp_write, stats);
+        
+        if (checkmax)
+        {
+          (*nmax)--;
+          if (!*nmax) break;
+        }
+      }
     }
+    else
+      singleread = false;
+  }
+  
+  if (ret < 0)
+    return ret;
+  
+  // last line of the file had no trailing newline
+  if (!singleread && !nskip && should_write)
+  {
+    (*nlines_out)++;
+    if (offsets)
+      write_offset(*nlines_in, line_offset, line_len, fp_write, stats);
   }
+  
+  return writer_flush(w, stats);
 }
 
 
@@ -86,28 +162,40 @@ static inline void read_header(char *buf, FILE *fp_read, FILE *fp_write, uint64_
  * Input.  Proportion of lines from input file to (randomly) retain.
  * The proportion retained is not guaranteed to be exactly p, but 
  * will be very close for large files.
+ * @param format
+ * Input.  FS_FORMAT_TEXT to write the retained lines, or
+ * FS_FORMAT_OFFSETS to write a record of where each of them is in the
+ * input (see fs_offset_t).  The sample is the same either way.
  * @param input
  * Input.  Absolute path to input file.
  * @param output
  * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().  With the writer thread,
+ * time_write is the time the scan spent waiting for free buffers.
  *
  * @note
  * Due to R's RNG, this call (as written) is very un-threadsafe.
+ * The text output is written from a second thread if more than one
+ * is allowed (see fs_set_nthreads()); the scan and the draws stay on
+ * the calling thread.
  * 
  * @return
  * The return value indicates the status of the function.
  */
-int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const char *input, const char *output)
+int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const int format, const char *input, const char *output, fs_stats_t *stats)
 {
   int ret = 0;
-  FILE *fp_read, *fp_write;
-  char *buf;
-  size_t readlen;
-  // Have to track cases where buffer is too small for fgets()
-  bool should_write = false;
-  bool singleread = true;
-  bool checkmax = nmax ? true : false;
+  reader_t r;
+  writer_t w;
+  FILE *fp_write;
+  bool async;
+  const bool checkmax = nmax ? true : false;
   uint64_t nlines_in = 0, nlines_out = 0;
+  const bool offsets = (format == FS_FORMAT_OFFSETS);
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
   
   if (p < 0. || p > 1.)
     return INVALID_PROB;
@@ -120,75 +208,81 @@ int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32
   }
   
   
-  fp_read = fopen(input, "r");
-  if (!fp_read)
-    return READ_FAIL;
+  ret = reader_open(&r, input);
+  if (ret)
+    return ret;
   
   fp_write = fopen(output, "w");
   if (!fp_write)
   {
-    fclose(fp_read);
+    reader_close(&r);
     return WRITE_FAIL;
   }
   
-  buf = malloc(BUFLEN * sizeof(char));
-  if (buf == NULL)
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  // for large p most of the output is runs of consecutive lines
+  ret = writer_open(&w, fp_write, input);
+  if (ret)
   {
-    fclose(fp_read);
+    writer_close(&w);
+    reader_close(&r);
     fclose(fp_write);
-    return MALLOC_FAIL;
+    return ret;
   }
   
   
-  if (header)
-    read_header(buf, fp_read, fp_write, &nlines_in, &nlines_out);
-  
-  
   STARTRNG;
   
-  while (fgets(buf, BUFLEN, fp_read) != NULL)
+  if (header)
   {
-    if ((nlines_out % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
-    {
-      ret = USER_INTERRUPT;
+    if (offsets)
+      ret = read_header_offset(&r, fp_write, &nlines_in, &nlines_out, stats);
+    else
+      ret = read_header(&r, fp_write, &nlines_in, &nlines_out, stats);
+    
+    if (ret)
       goto cleanup;
-    }
+  }
+  
+  // With a second thread, the output is written from it so that the scan
+  // doesn't wait on the writes; see writer_async_begin()
+  async = (!offsets && fs_get_nthreads() > 1);
+  
+  #ifdef _OPENMP
+  #pragma omp parallel num_threads(2) if(async)
+  #endif
+  {
+    if (fs_thread_num() == 0)
+      async = (async && fs_team_size() == 2 && writer_async_begin(&w) == 0);
     
-    if (singleread)
-    {
-      if (RUNIF < p)
-        should_write = true;
-      else
-        should_write = false;
-    }
+    #ifdef _OPENMP
+    #pragma omp barrier
+    #endif
     
-    if (nskip)
-      nskip--;
-    else if (should_write)
+    if (fs_thread_num() == 0)
     {
-      nlines_out++;
-      fprintf(fp_write, "%s", buf);
-      
-      if (checkmax)
+      ret = prop_scan(&r, &w, fp_write, offsets, nskip, &nmax, p, &nlines_in, &nlines_out, stats);
+      if (async)
       {
-        nmax--;
-        if (!nmax) break;
+        const int ret_end = writer_async_end(&w, stats);
+        if (!ret)
+          ret = ret_end;
       }
     }
-    
-    readlen = strnlen(buf, BUFLEN);
-    
-    // check if multiple reads for this one line are needed (i.e., line longer than buffer)
-    if (HAS_NEWLINE)
-    {
-      nlines_in++;
-      should_write = false;
-      singleread = true;
-    }
-    else
-      singleread = false;
+    else if (async)
+      writer_async_drain(&w);
   }
   
+  if (!ret && async)
+    ret = w.q->ret;
+  
+  if (ret)
+    goto cleanup;
+  
+  finalize_stats(r.bytes, r.nreads, reader_backend_name(&r), fp_write, start, write_start, nlines_in, nlines_out, stats);
+  writer_stats(&w, stats);
+  
   if (verbose)
   {
     if (checkmax && !nmax)
@@ -200,9 +294,9 @@ int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32
   
   cleanup:
     ENDRNG;
-    fclose(fp_read);
+    writer_close(&w);
+    reader_close(&r);
     fclose(fp_write);
-    free(buf);
   
   return ret;
 }
@@ -213,31 +307,35 @@ int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32
 // exact reader
 // ------------------------------------------------------
 
-static inline int unif_rand_int(const int low, const int high)
+static inline uint64_t unif_rand_int(const uint64_t low, const uint64_t high)
 {
-  return (int) low + (high + 1 - low)*RUNIF ;
+  return (uint64_t) (low + (high + 1 - low)*RUNIF);
 }
 
 
 
-static int res_sampler(const uint32_t nskip, const uint64_t nlines_in, const uint32_t nlines_out, uint64_t **samp)
+// A uniform sample of nlines_out of the N lines from nskip (0-based, after
+// the header), by Algorithm R; the same population as seqindex_init()
+// draws from for large samples.  If there are fewer than nlines_out lines,
+// the extra indices are past the end of the file and are never reached.
+static int res_sampler(const uint64_t nskip, const uint64_t N, const uint64_t nlines_out, uint64_t **samp)
 {
   *samp = malloc(nlines_out * sizeof(**samp));
-  if (samp == NULL)
+  if (*samp == NULL)
     return MALLOC_FAIL;
   
   SAFE_FOR_SIMD
-  for (uint32_t i=0; i<nlines_out; i++)
-    (*samp)[i] = nskip + i+1;
+  for (uint64_t i=0; i<nlines_out; i++)
+    (*samp)[i] = nskip + i;
   
   STARTRNG;
   
   SAFE_FOR_SIMD
-  for (uint64_t i=nlines_out; i<nlines_in; i++)
+  for (uint64_t i=nlines_out; i<N; i++)
   {
-    uint32_t j = unif_rand_int(0, i-1);
+    uint64_t j = unif_rand_int(0, i);
     if (j < nlines_out)
-      (*samp)[j] = nskip + i+1;
+      (*samp)[j] = nskip + i;
   }
   
   ENDRNG;
@@ -249,7 +347,366 @@ static int res_sampler(const uint32_t nskip, const uint64_t nlines_in, const uin
 
 static int comp(const void *a, const void *b)
 {
-  return *(uint64_t*)a - *(uint64_t*)b;
+  const uint64_t x = *(const uint64_t*)a;
+  const uint64_t y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+
+
+// ------------------------------------------------------
+// sequential index
+// ------------------------------------------------------
+
+// Samples of more than INDEX_MAX lines draw their index in increasing order,
+// INDEX_CHUNK lines at a time, rather than holding and sorting all of it
+#define INDEX_MAX (1 << 24)
+#define INDEX_CHUNK (1 << 20)
+
+
+
+// ------------------------------------------------------
+// parallel gather
+// ------------------------------------------------------
+
+// Blocks per chunk; each chunk is gathered by one thread into its own buffer
+#define CHUNK_BLOCKS 16
+
+// Chunks per thread gathered in each round; the buffers of a round are
+// written out (in order) before the next round starts
+#define CHUNKS_PER_THREAD 2
+
+typedef struct chunk_t
+{
+  // samples samp[lo:hi] start in this chunk
+  uint64_t lo;
+  uint64_t hi;
+  
+  char *buf;
+  size_t buflen;
+  uint64_t nlines;
+  int ret;
+} chunk_t;
+
+
+
+static void gather_chunk(gather_t *g, const bool header, const uint64_t *samp, chunk_t *ch)
+{
+  FILE *fp = open_memstream(&ch->buf, &ch->buflen);
+  if (fp == NULL)
+  {
+    ch->ret = MALLOC_FAIL;
+    return;
+  }
+  
+  for (uint64_t i=ch->lo; i<ch->hi; i++)
+  {
+    int ret = gather_line(g, samp[i] + header, fp, NULL);
+    if (ret <= 0)
+    {
+      ch->ret = ret;
+      break;
+    }
+    
+    ch->nlines++;
+  }
+  
+  if (fclose(fp) != 0 && ch->ret == 1)
+    ch->ret = MALLOC_FAIL;
+}
+
+
+
+// Parallel version of exact_gather().  The file is split into chunks of
+// CHUNK_BLOCKS blocks, and since samp is sorted, the samples of each chunk
+// are a contiguous range of it, found from the checkpoints.  Each thread
+// gathers whole chunks into memory, and the chunks are written in order.
+static int exact_gather_par(gather_t *g, const char *input, const int nthreads, const bool header, const uint64_t *samp, const uint64_t nlines_out, FILE *fp_write, uint64_t *lines_read, fs_stats_t *stats)
+{
+  int ret = 0;
+  int nopen = 0;
+  gather_t *gs;
+  chunk_t *chunks;
+  uint64_t first = 0;
+  const uint64_t nchunks = (g->ncheckpoints + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+  const uint64_t nround = (uint64_t) nthreads * CHUNKS_PER_THREAD;
+  // samp may be one piece of a sequential index; start at its first chunk
+  const uint64_t cstart = line_block(g->checkpoints, g->ncheckpoints, samp[0] + header) / CHUNK_BLOCKS;
+  
+  gs = malloc(nthreads * sizeof(*gs));
+  chunks = malloc(nround * sizeof(*chunks));
+  if (gs == NULL || chunks == NULL)
+  {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  for (; nopen<nthreads; nopen++)
+  {
+    ret = gather_open(gs + nopen, input, g->checkpoints, g->ncheckpoints);
+    if (ret)
+      goto cleanup;
+  }
+  
+  for (uint64_t c0=cstart; c0<nchunks && first<nlines_out; c0+=nround)
+  {
+    const uint64_t n = (c0 + nround < nchunks) ? nround : nchunks - c0;
+    
+    if (check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    // samples past the last checkpoint (or the end of the file) all go to
+    // the last chunk
+    for (uint64_t c=0; c<n; c++)
+    {
+      const uint64_t next = c0 + c + 1;
+      uint64_t hi = first;
+      
+      if (next == nchunks)
+        hi = nlines_out;
+      else
+      {
+        const uint64_t bound = g->checkpoints[next*CHUNK_BLOCKS];
+        while (hi < nlines_out && samp[hi] + header <= bound)
+          hi++;
+      }
+      
+      chunks[c].lo = first;
+      chunks[c].hi = hi;
+      chunks[c].buf = NULL;
+      chunks[c].buflen = 0;
+      chunks[c].nlines = 0;
+      chunks[c].ret = 1;
+      first = hi;
+    }
+    
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(nthreads) schedule(dynamic,1)
+    #endif
+    for (uint64_t c=0; c<n; c++)
+    {
+      if (chunks[c].lo < chunks[c].hi)
+        gather_chunk(gs + fs_thread_num(), header, samp, chunks + c);
+    }
+    
+    for (uint64_t c=0; c<n; c++)
+    {
+      if (chunks[c].ret < 0 && !ret)
+        ret = chunks[c].ret;
+      
+      // chunks without samples weren't gathered
+      if (!ret && chunks[c].buf != NULL)
+      {
+        write_buf(chunks[c].buf, chunks[c].buflen, fp_write, stats);
+        *lines_read += chunks[c].nlines;
+      }
+      
+      free(chunks[c].buf);
+    }
+    
+    if (ret)
+      goto cleanup;
+  }
+  
+  
+  cleanup:
+    for (int t=0; t<nopen; t++)
+    {
+      g->nreads += gs[t].nreads;
+      g->bytes += gs[t].bytes;
+      g->nlines += gs[t].nlines;
+      gather_close(gs + t);
+    }
+    
+    free(gs);
+    free(chunks);
+  
+  return ret;
+}
+
+
+
+// ------------------------------------------------------
+// offsets output
+// ------------------------------------------------------
+
+// The lines are found as by the gather pass, jumping to the block of the
+// next line with the checkpoints, but only their position is written.
+typedef struct offsets_t
+{
+  scan_t x;
+  const uint64_t *checkpoints;
+  uint64_t ncheckpoints;
+} offsets_t;
+
+
+
+// Write the record of line number `line` (0-based), which must not be before
+// the cursor.  Returns 1 if it was written and 0 if the file has no such line.
+static int offsets_line(offsets_t *o, const uint64_t line, FILE *fp_write, fs_stats_t *stats)
+{
+  int ret;
+  uint64_t start;
+  scan_t *x = &o->x;
+  
+  if (o->checkpoints && line > x->nlines)
+  {
+    const uint64_t b = line_block(o->checkpoints, o->ncheckpoints, line);
+    const uint64_t offset = b*FS_BLOCKLEN;
+    
+    if (offset > x->pos && offset >= x->boff + x->blen)
+    {
+      x->pos = offset;
+      x->nlines = o->checkpoints[b];
+    }
+  }
+  
+  if (line > x->nlines)
+  {
+    ret = scan_skip(x, line - x->nlines, NULL, stats);
+    if (ret <= 0)
+      return ret;
+  }
+  
+  start = x->pos;
+  if (start >= x->filesize)
+    return 0;
+  
+  ret = scan_skip(x, 1, NULL, stats);
+  if (ret < 0)
+    return ret;
+  
+  write_offset(line, start, x->pos - start, fp_write, stats);
+  
+  return 1;
+}
+
+
+
+// offsets second pass; samp holds post-header line numbers
+static int exact_offsets(offsets_t *o, const bool header, const uint64_t *samp, const uint64_t nlines_out, FILE *fp_write, uint64_t *lines_read, fs_stats_t *stats)
+{
+  int ret;
+  
+  for (uint64_t i=0; i<nlines_out; i++)
+  {
+    if ((i % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      return USER_INTERRUPT;
+    
+    ret = offsets_line(o, samp[i] + header, fp_write, stats);
+    if (ret < 0)
+      return ret;
+    else if (ret == 0)
+      break;
+    
+    (*lines_read)++;
+  }
+  
+  return 0;
+}
+
+
+
+// ------------------------------------------------------
+// exact sampler
+// ------------------------------------------------------
+
+// sequential second pass; the header (if any) has already been read
+static int exact_scan(reader_t *r, const uint64_t *samp, const uint64_t nlines_out, FILE *fp_write, uint64_t *lines_read, uint64_t *current_line, fs_stats_t *stats)
+{
+  int ret = 0;
+  char *buf;
+  size_t readlen;
+  // Lines straddling two blocks are read in pieces
+  bool should_write = false;
+  bool singleread = true;
+  
+  while (*lines_read < nlines_out && (ret = reader_getline(r, &buf, &readlen)) > 0)
+  {
+    if (singleread)
+    {
+      if ((*current_line % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+        return USER_INTERRUPT;
+      
+      if (samp[*lines_read] == *current_line)
+        should_write = true;
+      else
+        should_write = false;
+    }
+    
+    if (should_write)
+      write_buf(buf, readlen, fp_write, stats);
+    
+    if (HAS_NEWLINE)
+    {
+      (*current_line)++;
+      *lines_read += should_write;
+      singleread = true;
+    }
+    else
+      singleread = false;
+  }
+  
+  if (ret < 0)
+    return ret;
+  
+  // last line of the file had no trailing newline
+  if (!singleread && should_write)
+    (*lines_read)++;
+  
+  return 0;
+}
+
+
+
+// gather second pass; samp holds post-header line numbers
+static int exact_gather(gather_t *g, const bool header, const uint64_t *samp, const uint64_t nlines_out, FILE *fp_write, uint64_t *lines_read, fs_stats_t *stats)
+{
+  int ret;
+  
+  for (uint64_t i=0; i<nlines_out; i++)
+  {
+    if ((i % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      return USER_INTERRUPT;
+    
+    ret = gather_line(g, samp[i] + header, fp_write, stats);
+    if (ret < 0)
+      return ret;
+    else if (ret == 0)
+      break;
+    
+    (*lines_read)++;
+  }
+  
+  return 0;
+}
+
+
+
+// second pass over the lines of samp, which may be one piece of the index;
+// o is NULL unless the output is offsets
+static int exact_pass(gather_t *g, reader_t *r, offsets_t *o, const bool gather, const char *input, const int nthreads, const bool header, const uint64_t *samp, const uint64_t nlines_out, FILE *fp_write, uint64_t *lines_read, uint64_t *current_line, fs_stats_t *stats)
+{
+  int ret;
+  uint64_t n = 0;
+  
+  if (o)
+    ret = exact_offsets(o, header, samp, nlines_out, fp_write, &n, stats);
+  else if (gather)
+  {
+    if (nthreads > 1)
+      ret = exact_gather_par(g, input, nthreads, header, samp, nlines_out, fp_write, &n, stats);
+    else
+      ret = exact_gather(g, header, samp, nlines_out, fp_write, &n, stats);
+  }
+  else
+    ret = exact_scan(r, samp, nlines_out, fp_write, &n, current_line, stats);
+  
+  *lines_read += n;
+  return ret;
 }
 
 
@@ -267,6 +724,23 @@ static int comp(const void *a, const void *b)
  * If the file has many lines, it's probably just as good (and 
  * certainly much faster) to instead use file_sampler(), which
  * randomly subsamples at a proportion.
+ * 
+ * The first pass counts the lines and indexes the blocks of the
+ * file (see fs_wc_checkpoints()).  If the sample is small relative
+ * to the number of blocks, the second pass reads only the blocks
+ * holding the sampled lines with pread(); otherwise it scans the
+ * file from the start.
+ * 
+ * With more than one thread (see fs_set_nthreads()), both passes are
+ * parallel: the blocks are counted concurrently, and the second pass
+ * splits the sorted sample at chunk boundaries using the checkpoints,
+ * with each thread gathering the lines of a chunk into memory.  The
+ * chunks are written in file order, so the output is the same as
+ * with one thread.
+ * 
+ * With the offsets output, the second pass finds the sampled lines as
+ * the gather pass does, on one thread, but writes only their
+ * positions.
  *
  * @param header
  * Input.  Indicates whether or not there is a header line (as in a
@@ -279,10 +753,17 @@ static int comp(const void *a, const void *b)
  * @param nlines_out
  * Input.  The precise number of lines of input to (randomly) to 
  * retain.
+ * @param format
+ * Input.  FS_FORMAT_TEXT to write the retained lines, or
+ * FS_FORMAT_OFFSETS to write a record of where each of them is in the
+ * input (see fs_offset_t).  The sample is the same either way.
  * @param input
  * Input.  Absolute path to input file.
  * @param output
  * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
  *
  * @note
  * Due to R's RNG, this call (as written) is very un-threadsafe.
@@ -290,97 +771,163 @@ static int comp(const void *a, const void *b)
  * @return
  * The return value indicates the status of the function.
  */
-int fs_sample_exact(const bool verbose, const bool header, const uint32_t nskip, uint64_t nlines_out, const char *input, const char *output)
+int fs_sample_exact(const bool verbose, const bool header, const uint64_t nskip, uint64_t nlines_out, const int format, const char *input, const char *output, fs_stats_t *stats)
 {
   int ret;
-  FILE *fp_read, *fp_write;
-  char *buf;
-  size_t readlen;
-  // Have to track cases where buffer is too small for fgets()
-  bool should_write = false;
-  bool singleread = true;
-  uint64_t *samp;
+  reader_t r;
+  gather_t g;
+  offsets_t o;
+  seqindex_t seq;
+  FILE *fp_write;
+  bool gather;
+  bool sequential;
+  uint64_t *samp = NULL;
+  uint64_t *checkpoints;
+  uint64_t ncheckpoints;
   uint64_t nlines_in;
+  uint64_t ndata;
   uint64_t current_line = 0;
   uint64_t lines_read = 0;
+  double start;
+  double write_start;
+  const bool offsets = (format == FS_FORMAT_OFFSETS);
+  const int nthreads = fs_get_nthreads();
   
   
-  ret = fs_wc(input, false, NULL, false, NULL, true, &nlines_in);
+  ret = fs_wc_checkpoints(input, &nlines_in, &checkpoints, &ncheckpoints, stats);
   if (ret)
     return ret;
   
   
   if (nskip > nlines_in)
+  {
+    free(checkpoints);
     return INVALID_NSKIP;
+  }
   
-  fp_read = fopen(input, "r");
-  if (!fp_read) 
-    return READ_FAIL;
+  // lines after the header, counting a last line without a newline
+  ndata = nlines_in + last_line_unterminated(input);
+  if (header && ndata > 0)
+    ndata--;
   
-  fp_write = fopen(output, "w");
-  if (!fp_write)
+  gather = (!offsets && checkpoints != NULL && (nthreads > 1 || (nlines_out + header)*SPARSE_RATIO < ncheckpoints));
+  if (offsets)
   {
-    fclose(fp_read);
-    return WRITE_FAIL;
+    o.checkpoints = checkpoints;
+    o.ncheckpoints = ncheckpoints;
+    ret = scan_open(&o.x, input);
   }
+  else if (gather)
+    ret = gather_open(&g, input, checkpoints, ncheckpoints);
+  else
+    ret = reader_open(&r, input);
   
-  buf = malloc(BUFLEN * sizeof(char));
-  if (buf == NULL)
+  if (ret)
   {
-    fclose(fp_read);
-    fclose(fp_write);
-    return MALLOC_FAIL;
+    free(checkpoints);
+    return ret;
   }
   
-  
-  if (header)
-    read_header(buf, fp_read, fp_write, &nlines_in, &nlines_out);
-  
-  ret = res_sampler(nskip, nlines_in, nlines_out, &samp);
-  if (ret) 
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    ret = WRITE_FAIL;
     goto cleanup;
+  }
   
-  qsort(samp, nlines_out, sizeof(uint64_t), comp);
-  
-  STARTRNG;
-  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
   
-  while (fgets(buf, BUFLEN, fp_read) != NULL)
+  if (header)
   {
-    if (lines_read == nlines_out)
-      break;
-    
-    if ((lines_read % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    if (offsets || gather)
     {
-      ret = USER_INTERRUPT;
-      goto fullcleanup;
+      ret = offsets ? offsets_line(&o, 0, fp_write, stats) : gather_line(&g, 0, fp_write, stats);
+      if (ret == 1 && nlines_in > 0)
+      {
+        nlines_in++;
+        nlines_out++;
+      }
+      
+      ret = (ret < 0) ? ret : 0;
     }
+    else
+      ret = read_header(&r, fp_write, &nlines_in, &nlines_out, stats);
     
-    if (singleread)
+    if (ret)
+      goto cleanup;
+  }
+  
+  sequential = (nlines_out > INDEX_MAX);
+  if (sequential)
+  {
+    samp = malloc(INDEX_CHUNK * sizeof(*samp));
+    if (samp == NULL)
     {
-      if (samp[lines_read] == current_line)
-        should_write = true;
-      else
-        should_write = false;
+      ret = MALLOC_FAIL;
+      goto cleanup;
     }
     
-    if (should_write)
-    {
-      lines_read++;
-      fprintf(fp_write, "%s", buf);
-    }
+    seqindex_init(&seq, nskip, (ndata > nskip) ? ndata - nskip : 0, nlines_out);
+  }
+  else
+  {
+    start = fs_timer_now();
+    ret = res_sampler(nskip, (ndata > nskip) ? ndata - nskip : 0, nlines_out, &samp);
+    if (ret) 
+      goto cleanup;
     
-    readlen = strnlen(buf, BUFLEN);
+    if (stats)
+      stats->time_index += fs_timer_now() - start;
     
-    if (HAS_NEWLINE)
+    start = fs_timer_now();
+    qsort(samp, nlines_out, sizeof(uint64_t), comp);
+    if (stats)
+      stats->time_sort += fs_timer_now() - start;
+  }
+  
+  STARTRNG;
+  
+  start = fs_timer_now();
+  write_start = stats ? stats->time_write : 0.;
+  
+  if (sequential)
+  {
+    while (true)
     {
-      current_line++;
-      should_write = false;
-      singleread = true;
+      const double index_start = fs_timer_now();
+      const uint64_t n = seqindex_fill(&seq, samp, INDEX_CHUNK);
+      const double index_time = fs_timer_now() - index_start;
+      
+      // keep the index generation out of the sampling time
+      start += index_time;
+      if (stats)
+        stats->time_index += index_time;
+      
+      if (n == 0)
+        break;
+      
+      ret = exact_pass(&g, &r, offsets ? &o : NULL, gather, input, nthreads, header, samp, n, fp_write, &lines_read, &current_line, stats);
+      if (ret)
+        break;
     }
-    else
-      singleread = false;
   }
+  else
+    ret = exact_pass(&g, &r, offsets ? &o : NULL, gather, input, nthreads, header, samp, nlines_out, fp_write, &lines_read, &current_line, stats);
+  
+  if (offsets)
+    current_line = o.x.nlines;
+  else if (gather)
+    current_line = g.nlines;
+  
+  if (ret)
+    goto fullcleanup;
+  
+  if (offsets)
+    finalize_stats(o.x.bytes, o.x.nreads, "pread", fp_write, start, write_start, current_line, lines_read + header, stats);
+  else if (gather)
+    finalize_stats(g.bytes, g.nreads, "pread", fp_write, start, write_start, current_line, lines_read + header, stats);
+  else
+    finalize_stats(r.bytes, r.nreads, reader_backend_name(&r), fp_write, start, write_start, current_line + header, lines_read + header, stats);
   
   
   if (verbose)
@@ -392,12 +939,20 @@ int fs_sample_exact(const bool verbose, const bool header, const uint32_t nskip,
   
   fullcleanup:
     ENDRNG;
-    free(samp);
   
   cleanup:
-    fclose(fp_read);
-    fclose(fp_write);
-    free(buf);
+    free(samp);
+    if (offsets)
+      scan_close(&o.x);
+    else if (gather)
+      gather_close(&g);
+    else
+      reader_close(&r);
+    
+    if (fp_write)
+      fclose(fp_write);
+    
+    free(checkpoints);
   
   return ret;
 }
@@ -30,6 +30,7 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "error.h"
@@ -37,12 +38,220 @@
 #define BUFLEN 8192
 #define INTERRUPT_CHECK_NUM 1024
 
+// I/O backends; see fs_set_io_backend()
+#define FS_IO_AUTO  0
+#define FS_IO_STDIO 1
+#define FS_IO_URING 2
+
+// Page cache policies of the scans; see fs_set_cache_mode()
+#define FS_CACHE_DEFAULT 0
+#define FS_CACHE_KEEP    1
+#define FS_CACHE_DROP    2
+#define FS_CACHE_DIRECT  3
+
+// Output formats of fs_sample_prop() and fs_sample_exact()
+#define FS_FORMAT_TEXT    0
+#define FS_FORMAT_OFFSETS 1
+
+// Why fs_sample_anytime() stopped
+#define FS_STOP_DONE      0
+#define FS_STOP_TIME      1
+#define FS_STOP_BYTES     2
+#define FS_STOP_INTERRUPT 3
+
+
+// Instrumentation.  The core functions add to (rather than overwrite) the
+// fields, so a single object can follow several calls.  Initialize with
+// fs_stats_init(); passing NULL disables collection.
+typedef struct fs_stats_t
+{
+  // wall time (seconds) of each phase
+  double time_count;    // line counting pass
+  double time_index;    // sample index generation
+  double time_sort;     // sorting of the sample index
+  double time_sample;   // sampling pass, not including time_write
+  double time_write;    // writing of the retained lines
+  
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  uint64_t lines_read;
+  uint64_t lines_written;
+  // read/write requests issued to the OS
+  uint64_t nreads;
+  uint64_t nwrites;
+  
+  // name of the line counting kernel used, or NULL if none was
+  const char *kernel;
+  // name of the I/O backend used for reading
+  const char *backend;
+} fs_stats_t;
+
+
+// A record of the FS_FORMAT_OFFSETS output, in place of a sampled line: its
+// number (from 0, counting the header) and its bytes in the input, newline
+// included.  The records are in the order of the lines, in native byte order.
+typedef struct fs_offset_t
+{
+  uint64_t line;
+  uint64_t offset;
+  uint64_t len;
+} fs_offset_t;
+
+
+// Line length histogram; see fs_wc_linelen()
+#define FS_LINELEN_NBUCKETS 65
+
+typedef struct fs_linelen_t
+{
+  uint64_t nlines;
+  uint64_t nchars;
+  uint64_t min;
+  uint64_t max;
+  // counts[0] is always 0 and counts[b] is the number of lines with
+  // 2^(b-1) <= length < 2^b
+  uint64_t counts[FS_LINELEN_NBUCKETS];
+} fs_linelen_t;
+
+
+// Fields per line; see fs_wc_fields()
+#define FS_FIELDS_NANOMALIES 10
+
+typedef struct fs_fields_t
+{
+  uint64_t nlines;
+  uint64_t nchars;
+  // fields of the first line, and the fewest and most of any line
+  uint64_t nfields;
+  uint64_t min;
+  uint64_t max;
+  // lines (from 1) with a different number of fields than the first line;
+  // only the first FS_FIELDS_NANOMALIES are kept
+  uint64_t nanomalies;
+  uint64_t anomalies[FS_FIELDS_NANOMALIES];
+} fs_fields_t;
+
+
+// Single pass summary of a file; see fs_profile()
+typedef struct fs_profile_t
+{
+  uint64_t nlines;
+  uint64_t nchars;
+  // HyperLogLog estimates
+  double distinct_lines;
+  double distinct_keys;
+  // the most frequent keys (or lines), with Count-Min estimates of their
+  // counts, by decreasing count
+  int ntop;
+  char **top;
+  uint64_t *top_counts;
+} fs_profile_t;
+
+
+// The samples requested of one input by fs_sample_exact_batch(): nreq
+// samples of nlines_out[i] lines (after the header), written to outputs[i]
+typedef struct fs_batch_t
+{
+  const char *input;
+  int nreq;
+  const uint64_t *nlines_out;
+  const char **outputs;
+} fs_batch_t;
+
+
+// Column types of fs_table_t, from narrowest to widest
+#define FS_COL_LOGICAL 0
+#define FS_COL_INTEGER 1
+#define FS_COL_DOUBLE  2
+#define FS_COL_STRING  3
+
+// A field of fs_table_t: text[start] to text[start+len], NUL terminated
+typedef struct fs_field_t
+{
+  uint64_t start;
+  uint64_t len;
+} fs_field_t;
+
+// Sampled lines of a delimited file, split into fields; see fs_sample_table()
+typedef struct fs_table_t
+{
+  int ncols;
+  uint64_t nrows;
+  // the fields, unquoted, back to back
+  char *text;
+  uint64_t textlen;
+  // field j of row i is fields[i*ncols + j]
+  fs_field_t *fields;
+  // the header fields (NULL without a header), and the inferred FS_COL_* type
+  // of each column
+  fs_field_t *names;
+  int *types;
+} fs_table_t;
+
+
+// batch.c
+int fs_sample_exact_batch(const bool verbose, const bool header, const bool nested, const int max_reads, const int nfiles, const fs_batch_t *batch, fs_stats_t *stats);
+
+// block.c
+int fs_sample_block(const bool verbose, const bool header, const double p, const uint64_t blocksize, const char *input, const char *output, fs_stats_t *stats);
+int fs_sample_anytime(const bool verbose, const bool header, const uint64_t blocksize, const double time_limit, const uint64_t byte_limit, const char *input, const char *output, double *coverage, int *stopped, fs_stats_t *stats);
+
+// bootstrap.c
+int fs_sample_bootstrap(const bool verbose, const bool header, uint64_t nlines_out, const int nreps, const char *input, const char **outputs, fs_stats_t *stats);
+
 // file_sampler.c
-int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const char *input, const char *output);
-int fs_sample_exact(const bool verbose, const bool header, const uint32_t nskip, uint64_t nlines_out, const char *input, const char *output);
+int fs_sample_prop(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const int format, const char *input, const char *output, fs_stats_t *stats);
+int fs_sample_exact(const bool verbose, const bool header, const uint64_t nskip, uint64_t nlines_out, const int format, const char *input, const char *output, fs_stats_t *stats);
+
+// hashed.c
+int fs_sample_hash(const bool verbose, const bool header, const double p, const uint64_t seed, const uint32_t key, const char sep, const char *input, const char *output, fs_stats_t *stats);
+
+// incremental.c
+int fs_wc_incremental(const char *file, const char *state, uint64_t *nlines, fs_stats_t *stats);
+int fs_sample_reservoir(const bool verbose, const bool header, const uint64_t nlines_out, const char *input, const char *output, const char *state, fs_stats_t *stats);
+
+// part.c
+int fs_part_count(const char *input, const bool header, const int rank, const int nranks, uint64_t *nlines, fs_stats_t *stats);
+int fs_part_split(const uint64_t nlines_out, const int nranks, const uint64_t *counts, uint64_t *nlines_part);
+int fs_sample_part(const bool verbose, const bool header, const int rank, const int nranks, const uint64_t nlines_in, const uint64_t nlines_out, const char *input, const char *output, fs_stats_t *stats);
+
+// profile.c
+int fs_profile(const char *file, const bool header, const uint32_t key, const char sep, const int ntop, fs_profile_t *profile, fs_stats_t *stats);
+void fs_profile_free(fs_profile_t *profile);
+
+// range.c
+int fs_tail(const bool verbose, const bool header, const uint64_t n, const char *input, const char *output, fs_stats_t *stats);
+int fs_range(const bool verbose, const bool header, const uint64_t first, const uint64_t last, const char *input, const char *output, fs_stats_t *stats);
+
+// reader.c
+int fs_set_io_backend(const int backend);
+int fs_set_cache_mode(const int mode);
+
+// stats.c
+void fs_stats_init(fs_stats_t *stats);
+void fs_stats_print(const fs_stats_t *stats);
+
+// split.c
+int fs_sample_split(const bool verbose, const bool header, const int nout, const double *p, const bool hash, const uint64_t seed, const char *input, const char **outputs, fs_stats_t *stats);
+
+// systematic.c
+int fs_sample_systematic(const bool verbose, const bool header, uint32_t nskip, const uint64_t k, const char *input, const char *output, fs_stats_t *stats);
+
+// table.c
+int fs_sample_table(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const char sep, const char *input, fs_table_t *table, fs_stats_t *stats);
+void fs_table_fill_int(const fs_table_t *table, const int col, int32_t *x, const int32_t na);
+void fs_table_fill_double(const fs_table_t *table, const int col, double *x, const double na);
+bool fs_table_field(const fs_table_t *table, const uint64_t row, const int col, const char **s, size_t *len);
+void fs_table_free(fs_table_t *table);
+
+// threads.c
+int fs_set_nthreads(const int nthreads);
 
 // wc.c
-int fs_wc(const char *file, const bool chars, uint64_t *nchars, const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines);
+int fs_wc_linelen(const char *file, fs_linelen_t *ll, fs_stats_t *stats);
+int fs_wc_fields(const char *file, const char sep, fs_fields_t *f, fs_stats_t *stats);
+int fs_wc_checkpoints(const char *file, uint64_t *nlines, uint64_t **checkpoints, uint64_t *ncheckpoints, fs_stats_t *stats);
+int fs_wc(const char *file, const bool chars, uint64_t *nchars, const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines, fs_stats_t *stats);
+int fs_wc_many(const int nfiles, const char **files, const bool chars, uint64_t *nchars, const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines, fs_stats_t *stats);
 
 
 #endif
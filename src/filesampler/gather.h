@@ -0,0 +1,256 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+// Cursor over the blocks of a file indexed by fs_wc_checkpoints(), for
+// passes that read only the blocks holding the lines they want.
+
+#ifndef FILESAMPLER_GATHER_H_
+#define FILESAMPLER_GATHER_H_
+
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "sampler.h"
+
+
+// Use the gather pass when fewer than 1 in SPARSE_RATIO blocks hold a sample
+#define SPARSE_RATIO 4
+
+typedef struct gather_t
+{
+  int fd;
+  char *buf;
+  const uint64_t *checkpoints;
+  uint64_t ncheckpoints;
+  uint64_t filesize;
+  uint64_t block;
+  size_t blocklen;
+  // line number `line` starts at byte `pos` of the loaded block
+  uint64_t line;
+  size_t pos;
+  
+  uint64_t nreads;
+  uint64_t bytes;
+  uint64_t nlines;
+} gather_t;
+
+
+
+static inline int gather_open(gather_t *g, const char *input, const uint64_t *checkpoints, const uint64_t ncheckpoints)
+{
+  struct stat sb;
+  
+  g->fd = open(input, O_RDONLY);
+  if (g->fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(g->fd, &sb) != 0)
+  {
+    close(g->fd);
+    return READ_FAIL;
+  }
+  
+  g->buf = malloc(FS_BLOCKLEN);
+  if (g->buf == NULL)
+  {
+    close(g->fd);
+    return MALLOC_FAIL;
+  }
+  
+  g->checkpoints = checkpoints;
+  g->ncheckpoints = ncheckpoints;
+  g->filesize = (uint64_t) sb.st_size;
+  g->block = UINT64_MAX;
+  g->blocklen = 0;
+  g->line = UINT64_MAX;
+  g->pos = 0;
+  g->nreads = 0;
+  g->bytes = 0;
+  g->nlines = 0;
+  
+  return 0;
+}
+
+
+
+static inline void gather_close(gather_t *g)
+{
+  close(g->fd);
+  free(g->buf);
+}
+
+
+
+// returns 1 if the block was loaded, 0 if it is past the end of the file
+static inline int gather_load(gather_t *g, const uint64_t b)
+{
+  uint64_t offset;
+  size_t len;
+  
+  if (b == g->block)
+    return 1;
+  
+  offset = b*FS_BLOCKLEN;
+  if (b >= g->ncheckpoints || offset >= g->filesize)
+    return 0;
+  
+  len = (g->filesize - offset > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (g->filesize - offset);
+  g->block = UINT64_MAX;
+  g->blocklen = 0;
+  g->line = UINT64_MAX;
+  
+  if (pread_full(g->fd, g->buf, len, offset, &g->nreads))
+    return READ_FAIL;
+  
+  cache_done(g->fd, offset, len);
+  g->block = b;
+  g->blocklen = len;
+  g->bytes += len;
+  
+  return 1;
+}
+
+
+
+// The block holding the start of line number `line` (0-based).  The line
+// starts after the line'th newline, which is in the last block with fewer
+// than `line` newlines before it.
+static inline uint64_t line_block(const uint64_t *checkpoints, const uint64_t ncheckpoints, const uint64_t line)
+{
+  uint64_t lo = 0, hi = ncheckpoints;
+  
+  if (line == 0)
+    return 0;
+  
+  while (lo < hi)
+  {
+    const uint64_t mid = lo + (hi - lo)/2;
+    if (checkpoints[mid] < line)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  
+  return lo - 1;
+}
+
+
+
+// Write line number `line` (0-based) of the file to each of the nfp streams
+// of fp_write.  Returns 1 if it was written and 0 if the file has no such
+// line.  Lines should be requested in increasing order, so that lines in the
+// same block are found by scanning on from the previous one rather than from
+// the start of the block.
+static inline int gather_line_n(gather_t *g, const uint64_t line, FILE **fp_write, const int nfp, fs_stats_t *stats)
+{
+  int ret;
+  uint64_t b;
+  uint64_t skip;
+  size_t pos = 0;
+  bool written = false;
+  
+  b = line_block(g->checkpoints, g->ncheckpoints, line);
+  skip = (line == 0) ? 0 : line - g->checkpoints[b];
+  
+  if (g->line <= line && (b == g->block || g->line == line))
+  {
+    b = g->block;
+    pos = g->pos;
+    skip = line - g->line;
+  }
+  else
+  {
+    ret = gather_load(g, b);
+    if (ret <= 0)
+      return ret;
+  }
+  
+  while (skip)
+  {
+    char *nl = memchr(g->buf + pos, '\n', g->blocklen - pos);
+    if (nl == NULL)
+      return 0;
+    
+    pos = (size_t) (nl - g->buf) + 1;
+    skip--;
+    g->nlines++;
+  }
+  
+  while (true)
+  {
+    char *start;
+    char *nl;
+    size_t len;
+    
+    if (pos == g->blocklen)
+    {
+      ret = gather_load(g, ++b);
+      if (ret <= 0)
+        return (ret < 0) ? ret : written;
+      
+      pos = 0;
+    }
+    
+    start = g->buf + pos;
+    nl = memchr(start, '\n', g->blocklen - pos);
+    len = nl ? (size_t) (nl - start + 1) : g->blocklen - pos;
+    
+    for (int i=0; i<nfp; i++)
+      write_buf(start, len, fp_write[i], stats);
+    
+    written = true;
+    pos += len;
+    
+    if (nl)
+      break;
+  }
+  
+  g->nlines++;
+  g->line = line + 1;
+  g->pos = pos;
+  
+  return 1;
+}
+
+
+
+static inline int gather_line(gather_t *g, const uint64_t line, FILE *fp_write, fs_stats_t *stats)
+{
+  return gather_line_n(g, line, &fp_write, 1, stats);
+}
+
+
+#endif
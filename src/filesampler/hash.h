@@ -0,0 +1,134 @@
+// This file is free and unencumbered software released into the public domain.
+// You may modify it for any purpose with or without attribution.
+// See the Unlicense specification for full details http://unlicense.org/
+
+#ifndef FILESAMPLER_HASH_H_
+#define FILESAMPLER_HASH_H_
+
+
+#include <stdint.h>
+#include <string.h>
+
+// 64-bit wyhash (final version 4), by Wang Yi; public domain.  Inputs are
+// read as little-endian so that the hash of a line is the same everywhere.
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  #define FS_LE64(x) __builtin_bswap64(x)
+  #define FS_LE32(x) __builtin_bswap32(x)
+#else
+  #define FS_LE64(x) (x)
+  #define FS_LE32(x) (x)
+#endif
+
+static const uint64_t fs_wyp[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+static inline void fs_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = *a;
+  r *= *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t fs_mix(uint64_t a, uint64_t b)
+{
+  fs_mum(&a, &b);
+  return a ^ b;
+}
+
+static inline uint64_t fs_r8(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return FS_LE64(v);
+}
+
+static inline uint64_t fs_r4(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return FS_LE32(v);
+}
+
+static inline uint64_t fs_r3(const uint8_t *p, const size_t k)
+{
+  return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+static inline uint64_t fs_hash(const void *key, const size_t len, uint64_t seed)
+{
+  const uint8_t *p = (const uint8_t*) key;
+  uint64_t a, b;
+  
+  seed ^= fs_mix(seed ^ fs_wyp[0], fs_wyp[1]);
+  
+  if (len <= 16)
+  {
+    if (len >= 4)
+    {
+      a = (fs_r4(p) << 32) | fs_r4(p + ((len >> 3) << 2));
+      b = (fs_r4(p + len - 4) << 32) | fs_r4(p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0)
+    {
+      a = fs_r3(p, len);
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else
+  {
+    size_t i = len;
+    if (i > 48)
+    {
+      uint64_t see1 = seed, see2 = seed;
+      do
+      {
+        seed = fs_mix(fs_r8(p) ^ fs_wyp[1], fs_r8(p + 8) ^ seed);
+        see1 = fs_mix(fs_r8(p + 16) ^ fs_wyp[2], fs_r8(p + 24) ^ see1);
+        see2 = fs_mix(fs_r8(p + 32) ^ fs_wyp[3], fs_r8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      
+      seed ^= see1 ^ see2;
+    }
+    
+    while (i > 16)
+    {
+      seed = fs_mix(fs_r8(p) ^ fs_wyp[1], fs_r8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    
+    a = fs_r8(p + i - 16);
+    b = fs_r8(p + i - 8);
+  }
+  
+  a ^= fs_wyp[1];
+  b ^= seed;
+  fs_mum(&a, &b);
+  
+  return fs_mix(a ^ fs_wyp[0] ^ len, b ^ fs_wyp[1]);
+}
+
+// map a hash to [0, 1), like RUNIF
+static inline double fs_hash_unif(const uint64_t h)
+{
+  return (double) (h >> 11) * 0x1.0p-53;
+}
+
+
+#endif
@@ -0,0 +1,153 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filesampler.h"
+#include "hash.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+
+
+/**
+ * @file
+ * @brief 
+ * Hash File Sampler
+ *
+ * @details
+ * This function takes an input file and retains each line whose hash
+ * falls below p*2^64.  The hash is of the whole line (without its line
+ * ending) or of one of its fields, and of the seed.  So each line (or
+ * key) is retained with probability p, as with the proportional
+ * sampler, but whether it is depends only on its contents and the
+ * seed, and not on the RNG or the order of the lines.
+ * 
+ * In particular, sampling the pieces (shards) of a dataset separately
+ * and concatenating the results gives the same lines as sampling the
+ * whole dataset, so the shards can be sampled in parallel or on
+ * different machines.  Sampling on a key column retains either all of
+ * the lines with a given key or none of them.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).
+ * @param p
+ * Input.  Proportion of lines (or keys) to retain.
+ * @param seed
+ * Input.  Seed of the hash.
+ * @param key
+ * Input.  The field to hash (counting from 1), or 0 for the whole
+ * line.  Fields are separated by sep; quoting is not understood.
+ * @param sep
+ * Input.  The field separator.  Ignored if key is 0.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_hash(const bool verbose, const bool header, const double p, const uint64_t seed, const uint32_t key, const char sep, const char *input, const char *output, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  FILE *fp_write;
+  char *line;
+  size_t len;
+  uint64_t nlines_in = 0, nlines_out = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  if (p < 0. || p > 1.)
+    return INVALID_PROB;
+  
+  ret = reader_open(&r, input);
+  if (ret)
+    return ret;
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    reader_close(&r);
+    return WRITE_FAIL;
+  }
+  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  if (header)
+  {
+    ret = read_header(&r, fp_write, &nlines_in, &nlines_out, stats);
+    if (ret)
+      goto cleanup;
+  }
+  
+  while ((ret = reader_line(&r, &line, &len)) > 0)
+  {
+    const char *k;
+    size_t klen;
+    
+    if ((nlines_in % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    nlines_in++;
+    
+    line_key(line, len, key, sep, &k, &klen);
+    if (fs_hash_unif(fs_hash(k, klen, seed)) < p)
+    {
+      write_buf(line, len, fp_write, stats);
+      nlines_out++;
+    }
+  }
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  ret = 0;
+  finalize_stats(r.bytes, r.nreads, reader_backend_name(&r), fp_write, start, write_start, nlines_in, nlines_out, stats);
+  
+  if (verbose)
+    PRINTFUN("Read %llu lines (%.5f%%) of %llu line file.\n", nlines_out, (double) nlines_out/nlines_in, nlines_in);
+  
+  
+  cleanup:
+    reader_close(&r);
+    fclose(fp_write);
+  
+  return ret;
+}
@@ -0,0 +1,581 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filesampler.h"
+#include "hash.h"
+#include "linefeed.h"
+#include "sampler.h"
+#include "scan.h"
+#include "timer.h"
+#include "utils.h"
+#include "writer.h"
+
+
+#define STATE_MAGIC "filesampler-state"
+#define STATE_VERSION 1
+
+// The hash of the first FINGERPRINT_LEN bytes of the file (or all of them, if
+// it was shorter on the first call) identifies it from call to call.  Those
+// bytes never change in an append-only file.
+#define FINGERPRINT_LEN 4096
+
+
+typedef struct entry_t
+{
+  uint64_t offset;
+  uint64_t len;
+} entry_t;
+
+// What is known of the bytes [0, offset) of the file
+typedef struct state_t
+{
+  uint64_t offset;
+  uint64_t nlines;
+  uint64_t fp_hash;
+  uint64_t fp_len;
+  
+  // reservoir sampler only: size (0 for line counts), header length, data
+  // lines seen, and Algorithm L's next line and weight
+  uint64_t k;
+  int header;
+  uint64_t hlen;
+  uint64_t nseen;
+  uint64_t next;
+  double w;
+  entry_t *res;
+} state_t;
+
+
+
+static int state_init(state_t *st, const uint64_t k, const bool header)
+{
+  memset(st, 0, sizeof(*st));
+  st->k = k;
+  st->header = header;
+  
+  if (k > 0)
+  {
+    st->res = malloc(k * sizeof(*st->res));
+    if (st->res == NULL)
+      return MALLOC_FAIL;
+  }
+  
+  return 0;
+}
+
+
+
+// A missing state file is a fresh start
+static int state_read(const char *path, state_t *st)
+{
+  FILE *fp;
+  char magic[32];
+  int version;
+  uint64_t nres;
+  int ret = INVALID_STATE;
+  
+  fp = fopen(path, "r");
+  if (fp == NULL)
+    return (errno == ENOENT) ? 0 : READ_FAIL;
+  
+  if (fscanf(fp, "%31s %d", magic, &version) != 2 || strcmp(magic, STATE_MAGIC) != 0 || version != STATE_VERSION)
+    goto cleanup;
+  
+  if (fscanf(fp, " offset %" SCNu64 " nlines %" SCNu64 " fingerprint %" SCNu64 " %" SCNu64, &st->offset, &st->nlines, &st->fp_hash, &st->fp_len) != 4)
+    goto cleanup;
+  
+  if (fscanf(fp, " reservoir %" SCNu64 " %d %" SCNu64 " %" SCNu64 " %" SCNu64 " %la", &nres, &st->header, &st->hlen, &st->nseen, &st->next, &st->w) != 6)
+    goto cleanup;
+  
+  // made by another call
+  if (nres != st->k)
+    goto cleanup;
+  
+  nres = (st->nseen < st->k) ? st->nseen : st->k;
+  for (uint64_t i=0; i<nres; i++)
+  {
+    if (fscanf(fp, " %" SCNu64 " %" SCNu64, &st->res[i].offset, &st->res[i].len) != 2)
+      goto cleanup;
+  }
+  
+  ret = 0;
+  
+  cleanup:
+    fclose(fp);
+  
+  return ret;
+}
+
+
+
+// Written to a temporary file that then replaces the old state, so an
+// interrupted call leaves the old state intact
+static int state_write(const char *path, const state_t *st)
+{
+  int ret = 0;
+  FILE *fp;
+  const uint64_t nres = (st->nseen < st->k) ? st->nseen : st->k;
+  char *tmp = malloc(strlen(path) + 5);
+  if (tmp == NULL)
+    return MALLOC_FAIL;
+  
+  sprintf(tmp, "%s.tmp", path);
+  fp = fopen(tmp, "w");
+  if (fp == NULL)
+  {
+    free(tmp);
+    return WRITE_FAIL;
+  }
+  
+  fprintf(fp, "%s %d\n", STATE_MAGIC, STATE_VERSION);
+  fprintf(fp, "offset %" PRIu64 "\nnlines %" PRIu64 "\nfingerprint %" PRIu64 " %" PRIu64 "\n", st->offset, st->nlines, st->fp_hash, st->fp_len);
+  fprintf(fp, "reservoir %" PRIu64 " %d %" PRIu64 " %" PRIu64 " %" PRIu64 " %a\n", st->k, st->header, st->hlen, st->nseen, st->next, st->w);
+  for (uint64_t i=0; i<nres; i++)
+    fprintf(fp, "%" PRIu64 " %" PRIu64 "\n", st->res[i].offset, st->res[i].len);
+  
+  if (fclose(fp) != 0 || rename(tmp, path) != 0)
+    ret = WRITE_FAIL;
+  
+  free(tmp);
+  return ret;
+}
+
+
+
+static int fingerprint(scan_t *x, const uint64_t len, uint64_t *hash)
+{
+  if (len > 0 && pread_full(x->fd, x->buf, (size_t) len, 0, &x->nreads))
+    return READ_FAIL;
+  
+  x->bytes += len;
+  *hash = fs_hash(x->buf, (size_t) len, 0);
+  return 0;
+}
+
+
+
+// Start over if the file isn't the one the state was made from, or was
+// truncated
+static int state_check(scan_t *x, state_t *st)
+{
+  int ret;
+  uint64_t hash;
+  
+  if (st->offset > 0 && st->fp_len <= x->filesize && st->offset <= x->filesize)
+  {
+    ret = fingerprint(x, st->fp_len, &hash);
+    if (ret)
+      return ret;
+    
+    if (hash == st->fp_hash)
+      return 0;
+  }
+  
+  st->offset = 0;
+  st->nlines = 0;
+  st->hlen = 0;
+  st->nseen = 0;
+  st->next = 0;
+  st->w = 0.;
+  
+  st->fp_len = (x->filesize < FINGERPRINT_LEN) ? x->filesize : FINGERPRINT_LEN;
+  return fingerprint(x, st->fp_len, &st->fp_hash);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Incremental Line Count
+ *
+ * @details
+ * Counts the lines of a file like fs_wc(), but keeps what it has seen
+ * in a state file: the number of bytes scanned and the number of
+ * newlines in them.  The next call with the same state file only
+ * scans the bytes appended since, so for an append-only file (a log)
+ * the cost is proportional to the new data rather than to the size of
+ * the file.
+ *
+ * The state also holds a hash of the start of the file.  If the file
+ * no longer matches it, or is shorter than the bytes already counted
+ * (it was replaced, rotated or truncated), the count starts over.
+ *
+ * @param file
+ * Input.  Absolute path to input file.
+ * @param state
+ * Input.  Path to the state file.  It is created if it doesn't exist.
+ * @param nlines
+ * Output, passed by reference.  The number of newlines in the file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_wc_incremental(const char *file, const char *state, uint64_t *nlines, fs_stats_t *stats)
+{
+  int ret;
+  scan_t x;
+  state_t st;
+  uint64_t nblocks = 0;
+  const double start = fs_timer_now();
+  
+  ret = scan_open(&x, file);
+  if (ret)
+    return ret;
+  
+  state_init(&st, 0, false);
+  ret = state_read(state, &st);
+  if (!ret)
+    ret = state_check(&x, &st);
+  
+  if (ret)
+    goto cleanup;
+  
+  x.pos = st.offset;
+  while (x.pos < x.filesize)
+  {
+    const size_t len = (x.filesize - x.pos > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (x.filesize - x.pos);
+    
+    if ((++nblocks % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    if (pread_full(x.fd, x.buf, len, x.pos, &x.nreads))
+    {
+      ret = READ_FAIL;
+      goto cleanup;
+    }
+    
+    x.bytes += len;
+    st.nlines += linefeedcount(x.buf, len);
+    x.pos += len;
+  }
+  
+  st.offset = x.filesize;
+  ret = state_write(state, &st);
+  if (ret)
+    goto cleanup;
+  
+  *nlines = st.nlines;
+  
+  if (stats)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += x.bytes;
+    stats->nreads += x.nreads;
+    stats->lines_read += st.nlines;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = "pread";
+  }
+  
+  
+  cleanup:
+    scan_close(&x);
+  
+  return ret;
+}
+
+
+
+// End of the last whole line of the file, at or after offset
+static int last_line_end(scan_t *x, const uint64_t offset, uint64_t *end)
+{
+  uint64_t hi = x->filesize;
+  
+  while (hi > offset)
+  {
+    const size_t len = (hi - offset > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (hi - offset);
+    const uint64_t lo = hi - len;
+    
+    if (pread_full(x->fd, x->buf, len, lo, &x->nreads))
+      return READ_FAIL;
+    
+    x->bytes += len;
+    for (size_t i=len; i>0; i--)
+    {
+      if (x->buf[i-1] == '\n')
+      {
+        *end = lo + i;
+        return 0;
+      }
+    }
+    
+    hi = lo;
+  }
+  
+  *end = offset;
+  return 0;
+}
+
+
+
+// Algorithm L's weight and next line, after a reservoir of k lines is full
+// with line `line`
+static inline void reservoir_step(state_t *st, const uint64_t line)
+{
+  const double skip = floor(log(RUNIF) / log1p(-st->w));
+  
+  st->next = (skip < (double) (UINT64_MAX/2)) ? line + (uint64_t) skip + 1 : UINT64_MAX/2;
+}
+
+
+
+static int comp_entry(const void *a, const void *b)
+{
+  const uint64_t x = ((const entry_t*)a)->offset;
+  const uint64_t y = ((const entry_t*)b)->offset;
+  return (x > y) - (x < y);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Incremental Reservoir Sampler
+ *
+ * @details
+ * Draws an exact sample of nlines_out lines of a file in one pass,
+ * with a streaming reservoir (Li's Algorithm L), and keeps the
+ * reservoir in a state file along with the number of bytes and lines
+ * seen.  The next call with the same state file continues the stream
+ * with the bytes appended since, so the sample stays a uniform sample
+ * of the whole (grown) file while only the new data is read.
+ *
+ * The reservoir holds the offsets and lengths of the sampled lines, not
+ * the lines; they are copied from the file (in file order) when the
+ * output is written.  Algorithm L draws how many lines to skip between
+ * the ones that enter the reservoir, so those are only counted.  A
+ * last line without a newline may still be being written, so it is
+ * left for the next call.  The file check is as in
+ * fs_wc_incremental().
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line.  If so, it
+ * is written first and is not sampled.
+ * @param nlines_out
+ * Input.  The number of lines to sample (after the header).  If there
+ * are fewer, all of them are taken.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param state
+ * Input.  Path to the state file, which is created if it doesn't
+ * exist, or NULL for none.  It must have been made by a call with the
+ * same nlines_out and header.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_reservoir(const bool verbose, const bool header, const uint64_t nlines_out, const char *input, const char *output, const char *state, fs_stats_t *stats)
+{
+  int ret;
+  scan_t x;
+  state_t st;
+  writer_t w;
+  FILE *fp_write;
+  entry_t *sorted = NULL;
+  uint64_t end;
+  uint64_t nres;
+  uint64_t niter = 0;
+  const double start = fs_timer_now();
+  double write_start;
+  
+  if (nlines_out == 0)
+    return INVALID_NLINES;
+  
+  ret = scan_open(&x, input);
+  if (ret)
+    return ret;
+  
+  ret = state_init(&st, nlines_out, header);
+  if (ret)
+  {
+    scan_close(&x);
+    return ret;
+  }
+  
+  if (state)
+    ret = state_read(state, &st);
+  if (!ret && st.header != (int) header)
+    ret = INVALID_STATE;
+  if (!ret)
+    ret = state_check(&x, &st);
+  if (!ret)
+    ret = last_line_end(&x, st.offset, &end);
+  
+  if (ret)
+    goto cleanup;
+  
+  STARTRNG;
+  
+  // only the whole lines are scanned
+  x.filesize = end;
+  x.pos = st.offset;
+  
+  if (header && st.offset == 0 && end > 0)
+  {
+    ret = scan_skip(&x, 1, NULL, stats);
+    st.hlen = x.pos;
+  }
+  
+  while (ret >= 0 && x.pos < end)
+  {
+    uint64_t line_start;
+    uint64_t slot;
+    
+    if ((++niter % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    // lines between the ones that enter the reservoir
+    if (st.nseen >= st.k && st.next > st.nseen + 1)
+    {
+      const uint64_t before = x.nlines;
+      ret = scan_skip(&x, st.next - st.nseen - 1, NULL, stats);
+      st.nseen += x.nlines - before;
+      if (ret <= 0)
+        break;
+    }
+    
+    line_start = x.pos;
+    ret = scan_skip(&x, 1, NULL, stats);
+    if (ret <= 0)
+      break;
+    
+    st.nseen++;
+    if (st.nseen <= st.k)
+    {
+      slot = st.nseen - 1;
+      if (st.nseen == st.k)
+      {
+        st.w = exp(log(RUNIF) / (double) st.k);
+        reservoir_step(&st, st.nseen);
+      }
+    }
+    else
+    {
+      slot = (uint64_t) (st.k * RUNIF);
+      st.w *= exp(log(RUNIF) / (double) st.k);
+      reservoir_step(&st, st.nseen);
+    }
+    
+    st.res[slot].offset = line_start;
+    st.res[slot].len = x.pos - line_start;
+  }
+  
+  ENDRNG;
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  st.nlines += x.nlines;
+  st.offset = end;
+  
+  // the reservoir is written in file order; it is sorted in a copy so that
+  // its slots (and so the next call's draws) are as if the file had been
+  // sampled in one call
+  nres = (st.nseen < st.k) ? st.nseen : st.k;
+  sorted = malloc((nres ? nres : 1) * sizeof(*sorted));
+  if (sorted == NULL)
+  {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  memcpy(sorted, st.res, nres * sizeof(*sorted));
+  qsort(sorted, nres, sizeof(*sorted), comp_entry);
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    ret = WRITE_FAIL;
+    goto cleanup;
+  }
+  
+  write_start = stats ? stats->time_write : 0.;
+  ret = writer_open(&w, fp_write, input);
+  if (!ret && st.hlen > 0)
+    ret = writer_copy(&w, 0, st.hlen, stats);
+  
+  for (uint64_t i=0; i<nres && !ret; i++)
+    ret = writer_copy(&w, sorted[i].offset, sorted[i].len, stats);
+  
+  if (!ret)
+    ret = writer_flush(&w, stats);
+  
+  if (!ret)
+  {
+    finalize_stats(x.bytes + w.nbytes, x.nreads, writer_method_name(&w), fp_write, start, write_start, x.nlines, nres + (st.hlen > 0), stats);
+    writer_stats(&w, stats);
+  }
+  
+  writer_close(&w);
+  if (fclose(fp_write) != 0 && !ret)
+    ret = WRITE_FAIL;
+  
+  if (ret)
+    goto cleanup;
+  
+  if (state)
+    ret = state_write(state, &st);
+  
+  if (!ret && verbose)
+    PRINTFUN("Read %llu lines (%.5f%%) of %llu line file, %llu of them new.\n", nres, (double) nres/st.nseen, st.nseen, x.nlines);
+  
+  
+  cleanup:
+    free(sorted);
+    free(st.res);
+    scan_close(&x);
+  
+  return ret;
+}
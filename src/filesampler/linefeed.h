@@ -0,0 +1,183 @@
+/*  Copyright (c) 2015-2017, Drew Schmidt and Daniel Lemire
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FILESAMPLER_LINEFEED_H_
+#define FILESAMPLER_LINEFEED_H_
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "check_avx.h"
+
+
+#ifdef __AVX2__
+  // we have AVX2 support
+  #ifndef _MSC_VER
+    /* Non-Microsoft C/C++-compatible compiler */
+    #include <x86intrin.h> // on some recent GCC, this will declare posix_memalign
+  #else
+    /* Microsoft C/C++-compatible compiler */
+    #include <intrin.h>
+  #endif
+
+  // The byte counters are added up every LINEFEED_WINDOW vectors, before
+  // they can overflow; see
+  // http://lemire.me/blog/2017/02/14/how-fast-can-you-count-lines/
+  #define LINEFEED_WINDOW 255
+  
+  // Sum of the (unsigned) byte counters of cnt
+  static inline uint64_t linefeed_hsum_avx2(const __m256i cnt)
+  {
+    const __m256i sum = _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+    return (uint64_t) (_mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) + _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3));
+  }
+  
+  static inline size_t linefeedcount_avx2(char *const restrict buffer, const size_t size)
+  {
+    size_t answer = 0;
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    
+    while (i + 32 <= size)
+    {
+      __m256i cnt = _mm256_setzero_si256();
+      size_t howmanytimes = (size - i) / 32;
+      
+      if (howmanytimes > LINEFEED_WINDOW)
+        howmanytimes = LINEFEED_WINDOW;
+      
+      const __m256i *buf = (const __m256i*) (buffer + i);
+      size_t j = 0;
+      
+      for (; j + 3 < howmanytimes; j += 4)
+      {
+        __m256i cmp1 = _mm256_cmpeq_epi8(newline, _mm256_lddqu_si256(buf + j));
+        __m256i cmp2 = _mm256_cmpeq_epi8(newline, _mm256_lddqu_si256(buf + j + 1));
+        __m256i cmp3 = _mm256_cmpeq_epi8(newline, _mm256_lddqu_si256(buf + j + 2));
+        __m256i cmp4 = _mm256_cmpeq_epi8(newline, _mm256_lddqu_si256(buf + j + 3));
+        cnt = _mm256_sub_epi8(cnt, _mm256_add_epi8(cmp1, cmp2));
+        cnt = _mm256_sub_epi8(cnt, _mm256_add_epi8(cmp3, cmp4));
+      }
+      
+      for (; j < howmanytimes; j++)
+      {
+        __m256i cmp = _mm256_cmpeq_epi8(newline, _mm256_lddqu_si256(buf + j));
+        cnt = _mm256_sub_epi8(cnt, cmp);
+      }
+      
+      i += howmanytimes * 32;
+      answer += linefeed_hsum_avx2(cnt);
+    }
+    
+    for (; i < size; i++)
+    {
+      if (buffer[i] == '\n')
+        answer++;
+    }
+    
+    return answer;
+  }
+#endif
+
+
+
+static inline size_t linefeedcount_fallback(char *const restrict buffer, const size_t size)
+{
+  uint64_t nl = 0;
+  char *ptr = buffer;
+  char *last = buffer + size;
+  
+  while ((ptr = memchr(ptr, '\n', last - ptr)))
+  {
+    ptr++;
+    nl++;
+  }
+  
+  return nl;
+}
+
+
+
+static inline size_t linefeedcount(char *const restrict buffer, const size_t size)
+{
+#ifdef __AVX2__
+  if (has_avx2())
+    return linefeedcount_avx2(buffer, size);
+  else
+#endif
+    return linefeedcount_fallback(buffer, size);
+}
+
+
+
+static inline const char* linefeedcount_kernel()
+{
+#ifdef __AVX2__
+  if (has_avx2())
+    return "avx2";
+  else
+#endif
+    return "memchr";
+}
+
+
+
+// Offset of the n'th newline (n >= 1) counting forward from the start of the
+// buffer, or -1 if there are fewer than n.
+static inline int64_t linefeed_find(char *const restrict buffer, const size_t size, uint64_t n)
+{
+  char *ptr = buffer - 1;
+  char *last = buffer + size;
+  while (n-- > 0)
+  {
+    ptr = memchr(ptr + 1, '\n', last - (ptr + 1));
+    if (ptr == NULL)
+      return -1;
+  }
+  
+  return (int64_t) (ptr - buffer);
+}
+
+
+
+// Offset of the n'th newline (n >= 1) counting backward from the end of the
+// buffer.  Returns -1 if there are fewer than n, in which case *seen holds the
+// number there are.  Blocks that don't contain it cost one count.
+static inline int64_t linefeed_rfind(char *const restrict buffer, const size_t size, const uint64_t n, uint64_t *seen)
+{
+  const uint64_t nl = linefeedcount(buffer, size);
+  *seen = nl;
+  if (nl < n)
+    return -1;
+  
+  return linefeed_find(buffer, size, nl - n + 1);
+}
+
+
+
+#endif
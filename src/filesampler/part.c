@@ -0,0 +1,398 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "linefeed.h"
+#include "reader.h"
+#include "sampler.h"
+#include "scan.h"
+#include "seqindex.h"
+#include "timer.h"
+#include "utils.h"
+#include "writer.h"
+
+
+// Index chunk of fs_part_split() and fs_sample_part()
+#define PART_CHUNK (1 << 20)
+
+
+// Bytes [lo, hi) of the file are the part of rank `rank` of nranks
+static inline void part_bounds(const uint64_t filesize, const int rank, const int nranks, uint64_t *lo, uint64_t *hi)
+{
+  const uint64_t q = filesize / nranks;
+  const uint64_t r = filesize % nranks;
+  
+  *lo = q*rank + ((uint64_t) rank < r ? (uint64_t) rank : r);
+  *hi = *lo + q + ((uint64_t) rank < r ? 1 : 0);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Part Line Count
+ *
+ * @details
+ * This function counts the lines of one part of a file that is split
+ * into nranks parts of (nearly) equal bytes, for a distributed exact
+ * sample: each rank (of MPI, say) counts its own part, the counts are
+ * gathered on every rank, fs_part_split() splits the sample among the
+ * parts, and each rank draws its share with fs_sample_part().  The
+ * library itself makes no calls to MPI.
+ *
+ * A part holds the lines that start in its bytes.  Only the part's
+ * bytes are read, and by the newline counting kernel of fs_wc().
+ *
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param header
+ * Input.  Indicates whether or not there is a header line.  If so, it
+ * is not counted (it is in part 0).
+ * @param rank,nranks
+ * Input.  The part, 0 <= rank < nranks.
+ * @param nlines
+ * Output, passed by reference.  The number of lines of the part.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_part_count(const char *input, const bool header, const int rank, const int nranks, uint64_t *nlines, fs_stats_t *stats)
+{
+  int ret;
+  scan_t x;
+  uint64_t lo, hi;
+  uint64_t end;
+  uint64_t nblocks = 0;
+  const double start = fs_timer_now();
+  
+  *nlines = 0;
+  if (nranks < 1 || rank < 0 || rank >= nranks)
+    return INVALID_RANK;
+  
+  ret = scan_open(&x, input);
+  if (ret)
+    return ret;
+  
+  part_bounds(x.filesize, rank, nranks, &lo, &hi);
+  
+  // a line starts at lo if it is the start of the file or follows a newline;
+  // one starts at the end of the file only if it's empty
+  if (lo == 0 && hi > 0)
+  {
+    if (!header)
+      (*nlines)++;
+  }
+  
+  x.pos = (lo > 0) ? lo - 1 : 0;
+  end = (hi > 0) ? hi - 1 : 0;
+  
+  while (x.pos < end)
+  {
+    const size_t len = (end - x.pos > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (end - x.pos);
+    
+    if ((++nblocks % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    if (pread_full(x.fd, x.buf, len, x.pos, &x.nreads))
+    {
+      ret = READ_FAIL;
+      goto cleanup;
+    }
+    
+    x.bytes += len;
+    *nlines += linefeedcount(x.buf, len);
+    x.pos += len;
+  }
+  
+  if (stats)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += x.bytes;
+    stats->nreads += x.nreads;
+    stats->lines_read += *nlines;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = "pread";
+  }
+  
+  
+  cleanup:
+    scan_close(&x);
+  
+  return ret;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Split of a Distributed Sample
+ *
+ * @details
+ * This function splits an exact sample of nlines_out of the lines of
+ * all parts among the parts, with the (multivariate hypergeometric)
+ * distribution of the numbers of a uniform sample of the whole file
+ * that fall in each.  If each part then draws a uniform sample of its
+ * share, as fs_sample_part() does, the union is a uniform sample of
+ * the whole file.
+ *
+ * The split draws from the RNG, so either call it on every rank with
+ * the same seed, or on one rank and broadcast it.  It is drawn as a
+ * sequence of hypergeometric draws, one per part, with no I/O.
+ *
+ * @param nlines_out
+ * Input.  The size of the whole sample.  If it is more than the number
+ * of lines, all of them are taken.
+ * @param nranks
+ * Input.  The number of parts.
+ * @param counts
+ * Input.  The line counts of the parts; see fs_part_count().
+ * @param nlines_part
+ * Output.  The share of each part.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_part_split(const uint64_t nlines_out, const int nranks, const uint64_t *counts, uint64_t *nlines_part)
+{
+  uint64_t nlines = 0;
+  uint64_t left;
+  
+  if (nranks < 1)
+    return INVALID_RANK;
+  
+  for (int r=0; r<nranks; r++)
+    nlines += counts[r];
+  
+  left = (nlines_out < nlines) ? nlines_out : nlines;
+  
+  STARTRNG;
+  
+  // the share of each part is hypergeometric given those before it: of the
+  // lines not yet placed, how many fall in this part rather than the rest
+  for (int r=0; r<nranks-1; r++)
+  {
+    nlines -= counts[r];
+    if (left > 0 && counts[r] > 0)
+      nlines_part[r] = (uint64_t) RHYPER((double) counts[r], (double) nlines, (double) left);
+    else
+      nlines_part[r] = 0;
+    
+    left -= nlines_part[r];
+  }
+  
+  nlines_part[nranks-1] = left;
+  
+  ENDRNG;
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Part of a Distributed Exact Sample
+ *
+ * @details
+ * This function draws an exact sample of nlines_out of the nlines_in
+ * lines of one part of the file (see fs_part_count()), and writes them
+ * to its own output.  The outputs of parts 0 to nranks-1, concatenated
+ * in order, are then an exact sample of the whole file (with
+ * fs_part_split() shares), with the lines in file order.
+ *
+ * The sample index is drawn in order, a chunk at a time.  Lines
+ * between the sampled ones are skipped with the newline counting
+ * kernel, and runs of retained lines are copied by the kernel where
+ * possible; see writer_range().
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line.  If so,
+ * part 0 writes it first.
+ * @param rank,nranks
+ * Input.  The part, 0 <= rank < nranks.
+ * @param nlines_in
+ * Input.  The number of lines of the part, from fs_part_count().
+ * @param nlines_out
+ * Input.  The number of lines to sample from the part.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to the output file of the part.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.  Use a
+ * different seed (or stream) on each rank.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_part(const bool verbose, const bool header, const int rank, const int nranks, const uint64_t nlines_in, const uint64_t nlines_out, const char *input, const char *output, fs_stats_t *stats)
+{
+  int ret;
+  scan_t x;
+  writer_t w;
+  FILE *fp_write;
+  seqindex_t seq;
+  uint64_t *samp;
+  uint64_t lo, hi;
+  uint64_t line = 0;
+  uint64_t nwritten = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  if (nranks < 1 || rank < 0 || rank >= nranks)
+    return INVALID_RANK;
+  
+  ret = scan_open(&x, input);
+  if (ret)
+    return ret;
+  
+  samp = malloc(PART_CHUNK * sizeof(*samp));
+  if (samp == NULL)
+  {
+    scan_close(&x);
+    return MALLOC_FAIL;
+  }
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    free(samp);
+    scan_close(&x);
+    return WRITE_FAIL;
+  }
+  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  ret = writer_open(&w, fp_write, input);
+  if (ret)
+    goto cleanup;
+  
+  part_bounds(x.filesize, rank, nranks, &lo, &hi);
+  
+  // to the first line that starts in the part
+  if (lo > 0)
+  {
+    x.pos = lo - 1;
+    ret = scan_skip(&x, 1, NULL, stats);
+  }
+  else if (header && hi > 0)
+    ret = scan_skip(&x, 1, &w, stats);
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  STARTRNG;
+  
+  seqindex_init(&seq, 0, nlines_in, nlines_out);
+  while (ret >= 0 && seq.n > 0)
+  {
+    const uint64_t n = seqindex_fill(&seq, samp, PART_CHUNK);
+    
+    for (uint64_t i=0; i<n; i++)
+    {
+      if ((nwritten % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      {
+        ret = USER_INTERRUPT;
+        break;
+      }
+      
+      if (samp[i] > line)
+      {
+        ret = scan_skip(&x, samp[i] - line, NULL, stats);
+        if (ret <= 0)
+          break;
+      }
+      
+      ret = scan_skip(&x, 1, &w, stats);
+      if (ret < 0)
+        break;
+      
+      line = samp[i] + 1;
+      nwritten++;
+      
+      // the file ended in the sampled line
+      if (ret == 0)
+        break;
+    }
+    
+    if (ret == 0)
+      break;
+  }
+  
+  ENDRNG;
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  ret = writer_flush(&w, stats);
+  if (ret)
+    goto cleanup;
+  
+  if (rank == 0 && header && hi > 0)
+    nwritten++;
+  
+  finalize_stats(x.bytes, x.nreads, "pread", fp_write, start, write_start, line, nwritten, stats);
+  writer_stats(&w, stats);
+  
+  if (verbose)
+    PRINTFUN("Wrote %llu lines of the %llu in part %d of %d.\n", nwritten, nlines_in, rank, nranks);
+  
+  
+  cleanup:
+    writer_close(&w);
+    if (fclose(fp_write) != 0 && !ret)
+      ret = WRITE_FAIL;
+    
+    free(samp);
+    scan_close(&x);
+  
+  return ret;
+}
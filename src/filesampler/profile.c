@@ -0,0 +1,502 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "hash.h"
+#include "reader.h"
+#include "sampler.h"
+#include "sketch.h"
+#include "threads.h"
+#include "timer.h"
+#include "utils.h"
+
+
+// Bytes per chunk of the parallel scan
+#define PROFILE_CHUNKLEN (16*FS_BLOCKLEN)
+
+typedef struct profile_state_t
+{
+  fs_hll_t lines;
+  fs_hll_t keys;
+  fs_cms_t cms;
+  
+  // the last line of a chunk of the parallel scan, which runs past it
+  char *line;
+  size_t linelen;
+  size_t linesize;
+  
+  uint64_t nlines;
+  uint64_t nreads;
+} profile_state_t;
+
+
+
+static profile_state_t* profile_state_alloc(const int ntop)
+{
+  profile_state_t *ps = malloc(sizeof(*ps));
+  if (ps == NULL)
+    return NULL;
+  
+  memset(&ps->lines, 0, sizeof(ps->lines));
+  memset(&ps->keys, 0, sizeof(ps->keys));
+  fs_cms_init(&ps->cms, ntop);
+  ps->line = NULL;
+  ps->linelen = 0;
+  ps->linesize = 0;
+  ps->nlines = 0;
+  ps->nreads = 0;
+  
+  return ps;
+}
+
+
+
+static void profile_state_free(profile_state_t *ps)
+{
+  if (ps == NULL)
+    return;
+  
+  fs_cms_free(&ps->cms);
+  free(ps->line);
+  free(ps);
+}
+
+
+
+static inline int profile_line(profile_state_t *ps, const char *line, const size_t len, const uint32_t key, const char sep)
+{
+  const char *k;
+  size_t klen;
+  uint64_t h;
+  
+  line_key(line, len, 0, sep, &k, &klen);
+  h = fs_hash(k, klen, 0);
+  fs_hll_add(&ps->lines, h);
+  
+  if (key)
+  {
+    line_key(line, len, key, sep, &k, &klen);
+    h = fs_hash(k, klen, 0);
+    fs_hll_add(&ps->keys, h);
+  }
+  
+  return fs_cms_add(&ps->cms, h, k, klen);
+}
+
+
+
+// Sketch the lines starting in bytes [lo, hi) of the file.  The chunk is
+// read from lo-1, to tell whether lo starts a line, and the last line is
+// finished past hi.
+static int profile_range(profile_state_t *ps, const int fd, const uint64_t filesize, const uint64_t lo, const uint64_t hi, char *buf, const bool header, const uint32_t key, const char sep)
+{
+  int ret;
+  const uint64_t start = (lo > 0) ? lo - 1 : 0;
+  const size_t len = (size_t) (((hi < filesize) ? hi : filesize) - start);
+  char *p = buf;
+  char *end = buf + len;
+  
+  if (pread_full(fd, buf, len, start, &ps->nreads))
+    return READ_FAIL;
+  
+  if (lo > 0 || header)
+  {
+    char *nl = memchr(buf, '\n', len);
+    if (nl == NULL)
+      return 0;
+    
+    // the header is counted but not sketched
+    if (lo == 0)
+      ps->nlines++;
+    
+    p = nl + 1;
+  }
+  
+  while (p < end)
+  {
+    char *nl = memchr(p, '\n', end - p);
+    uint64_t offset;
+    
+    if (nl)
+    {
+      ret = profile_line(ps, p, nl - p + 1, key, sep);
+      if (ret)
+        return ret;
+      
+      ps->nlines++;
+      p = nl + 1;
+      continue;
+    }
+    
+    // the last line runs past the chunk
+    ps->linelen = 0;
+    offset = start + len;
+    while (true)
+    {
+      const size_t n = end - p;
+      if (ps->linelen + n > ps->linesize)
+      {
+        size_t size = 2*ps->linesize + BUFLEN;
+        char *tmp;
+        
+        if (size < ps->linelen + n)
+          size = ps->linelen + n;
+        
+        tmp = realloc(ps->line, size);
+        if (tmp == NULL)
+          return MALLOC_FAIL;
+        
+        ps->line = tmp;
+        ps->linesize = size;
+      }
+      
+      memcpy(ps->line + ps->linelen, p, n);
+      ps->linelen += n;
+      
+      if ((nl && nl < end) || offset >= filesize)
+        break;
+      
+      // continue into buf, which the chunk no longer needs
+      p = buf;
+      end = buf + ((filesize - offset > BUFLEN) ? BUFLEN : (size_t) (filesize - offset));
+      if (pread_full(fd, buf, end - buf, offset, &ps->nreads))
+        return READ_FAIL;
+      
+      offset += end - buf;
+      nl = memchr(p, '\n', end - p);
+      if (nl)
+        end = nl + 1;
+    }
+    
+    ret = profile_line(ps, ps->line, ps->linelen, key, sep);
+    if (ret)
+      return ret;
+    
+    if (ps->line[ps->linelen - 1] == '\n')
+      ps->nlines++;
+    
+    break;
+  }
+  
+  return 0;
+}
+
+
+
+static int profile_par(const char *file, const int nthreads, const bool header, const uint32_t key, const char sep, const int ntop, profile_state_t **out, uint64_t *nchars)
+{
+  int ret = 0;
+  int fd;
+  struct stat sb;
+  uint64_t filesize, nchunks;
+  char *bufs = NULL;
+  int *rets = NULL;
+  profile_state_t **ps = NULL;
+  
+  fd = open(file, O_RDONLY);
+  if (fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(fd);
+    return 1;
+  }
+  
+  filesize = (uint64_t) sb.st_size;
+  nchunks = (filesize + PROFILE_CHUNKLEN - 1) / PROFILE_CHUNKLEN;
+  
+  // chunks after the first are read from one byte before their start
+  bufs = malloc((size_t) nthreads * (PROFILE_CHUNKLEN + 1));
+  rets = calloc(nthreads, sizeof(*rets));
+  ps = calloc(nthreads, sizeof(*ps));
+  if (bufs == NULL || rets == NULL || ps == NULL)
+  {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  for (int t=0; t<nthreads; t++)
+  {
+    ps[t] = profile_state_alloc(ntop);
+    if (ps[t] == NULL)
+    {
+      ret = MALLOC_FAIL;
+      goto cleanup;
+    }
+  }
+  
+  for (uint64_t c0=0; c0<nchunks; c0+=nthreads)
+  {
+    const uint64_t c1 = (c0 + nthreads < nchunks) ? c0 + nthreads : nchunks;
+    
+    if (check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(nthreads) schedule(static,1)
+    #endif
+    for (uint64_t c=c0; c<c1; c++)
+    {
+      const int t = fs_thread_num();
+      const uint64_t lo = c*PROFILE_CHUNKLEN;
+      const int r = profile_range(ps[t], fd, filesize, lo, lo + PROFILE_CHUNKLEN, bufs + (size_t) t*(PROFILE_CHUNKLEN + 1), header, key, sep);
+      if (r)
+        rets[t] = r;
+    }
+    
+    for (int t=0; t<nthreads; t++)
+    {
+      if (rets[t])
+      {
+        ret = rets[t];
+        goto cleanup;
+      }
+    }
+  }
+  
+  for (int t=1; t<nthreads; t++)
+  {
+    fs_hll_merge(&ps[0]->lines, &ps[t]->lines);
+    fs_hll_merge(&ps[0]->keys, &ps[t]->keys);
+    ret = fs_cms_merge(&ps[0]->cms, &ps[t]->cms);
+    if (ret)
+      goto cleanup;
+    
+    ps[0]->nlines += ps[t]->nlines;
+    ps[0]->nreads += ps[t]->nreads;
+  }
+  
+  *out = ps[0];
+  ps[0] = NULL;
+  *nchars = filesize;
+  
+  
+  cleanup:
+    close(fd);
+    if (ps)
+    {
+      for (int t=0; t<nthreads; t++)
+        profile_state_free(ps[t]);
+    }
+    
+    free(ps);
+    free(rets);
+    free(bufs);
+  
+  return ret;
+}
+
+
+
+static int profile_serial(const char *file, const bool header, const uint32_t key, const char sep, const int ntop, profile_state_t **out, uint64_t *nchars, uint64_t *nreads, const char **backend)
+{
+  int ret;
+  reader_t r;
+  char *line;
+  size_t len;
+  profile_state_t *ps;
+  
+  ps = profile_state_alloc(ntop);
+  if (ps == NULL)
+    return MALLOC_FAIL;
+  
+  ret = reader_open(&r, file);
+  if (ret)
+  {
+    profile_state_free(ps);
+    return ret;
+  }
+  
+  while ((ret = reader_line(&r, &line, &len)) > 0)
+  {
+    if ((ps->nlines % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    if (!header || ps->nlines > 0)
+    {
+      ret = profile_line(ps, line, len, key, sep);
+      if (ret)
+        break;
+    }
+    
+    ps->nlines += (line[len-1] == '\n');
+  }
+  
+  *nchars = r.bytes;
+  *nreads = r.nreads;
+  *backend = reader_backend_name(&r);
+  reader_close(&r);
+  
+  if (ret)
+  {
+    profile_state_free(ps);
+    return ret;
+  }
+  
+  *out = ps;
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * File Profile
+ *
+ * @details
+ * Counts the lines of a file like fs_wc(), and in the same pass
+ * estimates the number of distinct lines and of distinct keys (values
+ * of one field) with HyperLogLog sketches, and finds the most frequent
+ * keys (or lines) with a Count-Min sketch.  The distinct counts have a
+ * relative standard error of about 0.8%.  The frequencies of the top
+ * keys are overestimates, by at most about 0.07% of the number of
+ * lines with high probability.
+ * 
+ * If more than one thread is available (see fs_set_nthreads()) and the
+ * input is a regular file, the file is split into chunks which are
+ * sketched concurrently, and the sketches are merged.
+ *
+ * @param file
+ * Input.  Absolute path to the file.
+ * @param header
+ * Input.  Indicates whether or not there is a header line.  If so, it
+ * is counted but not sketched.
+ * @param key
+ * Input.  The key field (counting from 1), or 0 to use whole lines.
+ * Fields are separated by sep; quoting is not understood.
+ * @param sep
+ * Input.  The field separator.  Ignored if key is 0.
+ * @param ntop
+ * Input.  The number of most frequent keys to return, at most
+ * FS_TOPK_MAX.
+ * @param profile
+ * Output, passed by reference.  Free its contents with
+ * fs_profile_free().
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_profile(const char *file, const bool header, const uint32_t key, const char sep, const int ntop, fs_profile_t *profile, fs_stats_t *stats)
+{
+  int ret = 1;
+  profile_state_t *ps = NULL;
+  uint64_t nchars = 0;
+  uint64_t nreads = 0;
+  const char *backend = "pread";
+  const int nthreads = fs_get_nthreads();
+  const double start = fs_timer_now();
+  
+  memset(profile, 0, sizeof(*profile));
+  
+  if (nthreads > 1)
+  {
+    ret = profile_par(file, nthreads, header, key, sep, ntop, &ps, &nchars);
+    if (ret < 0)
+      return ret;
+    else if (ret == 0)
+      nreads = ps->nreads;
+  }
+  
+  if (ret)
+  {
+    ret = profile_serial(file, header, key, sep, ntop, &ps, &nchars, &nreads, &backend);
+    if (ret)
+      return ret;
+  }
+  
+  fs_cms_sort(&ps->cms);
+  
+  profile->nlines = ps->nlines;
+  profile->nchars = nchars;
+  profile->distinct_lines = fs_hll_estimate(&ps->lines);
+  profile->distinct_keys = key ? fs_hll_estimate(&ps->keys) : profile->distinct_lines;
+  
+  // the keys are handed over as they are
+  profile->ntop = ps->cms.ntop;
+  profile->top = malloc((ps->cms.ntop + 1) * sizeof(*profile->top));
+  profile->top_counts = malloc((ps->cms.ntop + 1) * sizeof(*profile->top_counts));
+  if (profile->top == NULL || profile->top_counts == NULL)
+  {
+    fs_profile_free(profile);
+    profile_state_free(ps);
+    return MALLOC_FAIL;
+  }
+  
+  for (int i=0; i<ps->cms.ntop; i++)
+  {
+    profile->top[i] = ps->cms.top[i].key;
+    profile->top_counts[i] = ps->cms.top[i].count;
+  }
+  
+  ps->cms.ntop = 0;
+  profile_state_free(ps);
+  
+  if (stats)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += nchars;
+    stats->nreads += nreads;
+    stats->lines_read += profile->nlines;
+    stats->backend = backend;
+  }
+  
+  return 0;
+}
+
+
+
+void fs_profile_free(fs_profile_t *profile)
+{
+  if (profile->top)
+  {
+    for (int i=0; i<profile->ntop; i++)
+      free(profile->top[i]);
+  }
+  
+  free(profile->top);
+  free(profile->top_counts);
+  profile->top = NULL;
+  profile->top_counts = NULL;
+  profile->ntop = 0;
+}
@@ -0,0 +1,401 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "linefeed.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+#include "writer.h"
+
+
+typedef struct extract_t
+{
+  int fd;
+  char *buf;
+  uint64_t filesize;
+  uint64_t nreads;
+  uint64_t bytes_read;
+} extract_t;
+
+
+
+static int extract_open(extract_t *x, const char *input)
+{
+  struct stat sb;
+  
+  x->fd = open(input, O_RDONLY);
+  if (x->fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(x->fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(x->fd);
+    return READ_FAIL;
+  }
+  
+  x->buf = malloc(FS_BLOCKLEN);
+  if (x->buf == NULL)
+  {
+    close(x->fd);
+    return MALLOC_FAIL;
+  }
+  
+  x->filesize = (uint64_t) sb.st_size;
+  x->nreads = 0;
+  x->bytes_read = 0;
+  
+  return 0;
+}
+
+
+
+static void extract_close(extract_t *x)
+{
+  close(x->fd);
+  free(x->buf);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// finding line boundaries
+// -----------------------------------------------------------------------------
+
+// Offset just past the n'th newline at or after offset, or the end of the
+// file if there are fewer.  *found is the number of newlines passed.  Blocks
+// that don't hold the n'th newline are only counted.
+static int find_forward(extract_t *x, uint64_t offset, uint64_t n, uint64_t *end, uint64_t *found)
+{
+  uint64_t nblocks = 0;
+  *found = 0;
+  
+  while (n > 0 && offset < x->filesize)
+  {
+    size_t len = (x->filesize - offset > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (x->filesize - offset);
+    
+    if ((++nblocks % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      return USER_INTERRUPT;
+    
+    if (pread_full(x->fd, x->buf, len, offset, &x->nreads))
+      return READ_FAIL;
+    
+    x->bytes_read += len;
+    
+    const uint64_t nl = linefeedcount(x->buf, len);
+    if (nl >= n)
+    {
+      *end = offset + (uint64_t) linefeed_find(x->buf, len, n) + 1;
+      *found += n;
+      return 0;
+    }
+    
+    n -= nl;
+    *found += nl;
+    offset += len;
+  }
+  
+  *end = (n > 0) ? x->filesize : offset;
+  return 0;
+}
+
+
+
+static int ends_with_newline(extract_t *x, bool *nl)
+{
+  *nl = false;
+  if (x->filesize == 0)
+    return 0;
+  
+  if (pread_full(x->fd, x->buf, 1, x->filesize - 1, &x->nreads))
+    return READ_FAIL;
+  
+  x->bytes_read++;
+  *nl = (x->buf[0] == '\n');
+  return 0;
+}
+
+
+
+// Start of the n'th to last line of the file that begins at or after lo.
+// A final newline ends the last line rather than starting an empty one.
+// *nlines is the number of lines from there to the end of the file, which
+// is less than n if the file doesn't have that many.
+static int find_backward(extract_t *x, const uint64_t lo, uint64_t n, uint64_t *start, uint64_t *nlines)
+{
+  int ret;
+  bool nl_end;
+  uint64_t hi = x->filesize;
+  uint64_t seen = 0;
+  const uint64_t want = n;
+  
+  *nlines = 0;
+  if (n == 0 || lo >= hi)
+  {
+    *start = hi;
+    return 0;
+  }
+  
+  ret = ends_with_newline(x, &nl_end);
+  if (ret)
+    return ret;
+  
+  if (nl_end)
+    hi--;
+  
+  while (hi > lo)
+  {
+    size_t len = (hi - lo > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (hi - lo);
+    uint64_t offset = hi - len;
+    uint64_t nl;
+    
+    if (pread_full(x->fd, x->buf, len, offset, &x->nreads))
+      return READ_FAIL;
+    
+    x->bytes_read += len;
+    
+    int64_t pos = linefeed_rfind(x->buf, len, n, &nl);
+    if (pos >= 0)
+    {
+      *start = offset + (uint64_t) pos + 1;
+      *nlines = want;
+      return 0;
+    }
+    
+    n -= nl;
+    seen += nl;
+    hi = offset;
+  }
+  
+  // fewer than n lines; all of them
+  *start = lo;
+  *nlines = seen + 1;
+  return 0;
+}
+
+
+
+// Shared driver: with tail, the last n lines; otherwise lines first through
+// last.  Line numbers don't include the header.
+static int extract(const bool verbose, const bool header, const bool tail, const uint64_t n, const uint64_t first, const uint64_t last, const char *input, const char *output, fs_stats_t *stats)
+{
+  int ret;
+  extract_t x;
+  writer_t w;
+  FILE *fp_write;
+  uint64_t lo = 0;
+  uint64_t from, to;
+  uint64_t found;
+  uint64_t nlines = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  double count_end;
+  
+  ret = extract_open(&x, input);
+  if (ret)
+    return ret;
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    extract_close(&x);
+    return WRITE_FAIL;
+  }
+  
+  ret = writer_open(&w, fp_write, input);
+  if (ret)
+    goto cleanup;
+  
+  if (header)
+  {
+    ret = find_forward(&x, 0, 1, &lo, &found);
+    if (ret)
+      goto cleanup;
+    
+    if (lo > 0)
+      nlines++;
+  }
+  
+  if (tail)
+  {
+    uint64_t nlines_tail;
+    ret = find_backward(&x, lo, n, &from, &nlines_tail);
+    to = x.filesize;
+    nlines += nlines_tail;
+  }
+  else
+  {
+    ret = find_forward(&x, lo, first - 1, &from, &found);
+    if (!ret && found == first - 1 && from < x.filesize)
+    {
+      const uint64_t want = last - first + 1;
+      ret = find_forward(&x, from, want, &to, &found);
+      nlines += found;
+      
+      // ran into the end of a file without a final newline
+      if (!ret && found < want)
+      {
+        bool nl_end;
+        ret = ends_with_newline(&x, &nl_end);
+        if (!nl_end)
+          nlines++;
+      }
+    }
+    else
+      to = from = x.filesize;
+  }
+  
+  if (ret)
+    goto cleanup;
+  
+  count_end = fs_timer_now();
+  
+  // the header and the lines are copied together when they are adjacent
+  if (from == lo)
+    ret = writer_copy(&w, 0, to, stats);
+  else
+  {
+    ret = writer_copy(&w, 0, lo, stats);
+    if (!ret)
+      ret = writer_copy(&w, from, to - from, stats);
+  }
+  
+  if (ret)
+    goto cleanup;
+  
+  if (stats)
+  {
+    stats->time_count += count_end - start;
+    stats->kernel = linefeedcount_kernel();
+  }
+  
+  // the copied bytes are read by the kernel
+  finalize_stats(x.bytes_read + w.nbytes, x.nreads, writer_method_name(&w), fp_write, count_end, write_start, nlines, nlines, stats);
+  writer_stats(&w, stats);
+  
+  if (verbose)
+    PRINTFUN("Wrote %llu lines (%llu bytes) after reading %llu of %llu bytes.\n", nlines, w.nbytes, x.bytes_read, x.filesize);
+  
+  
+  cleanup:
+    writer_close(&w);
+    if (fclose(fp_write) != 0 && !ret)
+      ret = WRITE_FAIL;
+    
+    extract_close(&x);
+  
+  return ret;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * File Tail
+ *
+ * @details
+ * This function writes the last n lines of the input file.  It reads
+ * the file backward from the end in large blocks, counting newlines
+ * until it has passed n of them, so the cost is proportional to the
+ * size of the output rather than of the file.  The lines are then
+ * copied out by the kernel where possible; see writer_copy().
+ *
+ * @param verbose
+ * Input.  Indicates whether line/byte counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).  If so, it is written first and is not counted among the
+ * last n lines.
+ * @param n
+ * Input.  Number of lines to write.  If the file has fewer, all of
+ * them are written.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_tail(const bool verbose, const bool header, const uint64_t n, const char *input, const char *output, fs_stats_t *stats)
+{
+  return extract(verbose, header, true, n, 0, 0, input, output, stats);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * File Line Range
+ *
+ * @details
+ * This function writes lines first through last (counting from 1) of
+ * the input file.  It finds where they start and end with the newline
+ * counting kernel of fs_wc() (only the block holding a boundary is
+ * searched line by line), reading no further than line last.  The
+ * lines are then copied out as in fs_tail().
+ *
+ * @param verbose
+ * Input.  Indicates whether line/byte counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).  If so, it is written first and line numbers start after it.
+ * @param first,last
+ * Input.  The range of lines to write, 1 <= first <= last.  Lines
+ * past the end of the file are ignored.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_range(const bool verbose, const bool header, const uint64_t first, const uint64_t last, const char *input, const char *output, fs_stats_t *stats)
+{
+  if (first == 0 || last < first)
+    return INVALID_RANGE;
+  
+  return extract(verbose, header, false, 0, first, last, input, output, stats);
+}
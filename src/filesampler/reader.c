@@ -0,0 +1,845 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// O_DIRECT
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "filesampler.h"
+#include "reader.h"
+
+#ifdef FS_HAVE_IO_URING
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/syscall.h>
+  #include <sys/uio.h>
+  #include <unistd.h>
+#endif
+
+
+static int io_backend = FS_IO_AUTO;
+static int cache_mode = FS_CACHE_DEFAULT;
+
+/**
+ * @file
+ * @brief
+ * Set the I/O Backend
+ *
+ * @details
+ * Chooses how the scanning loops of fs_wc() and the samplers read their
+ * input.  FS_IO_STDIO uses blocking fread() calls.  FS_IO_URING keeps
+ * several reads in flight with io_uring, so the next blocks are already
+ * being read while the current one is processed.  FS_IO_AUTO (the
+ * default) uses io_uring where possible.  If io_uring is not available
+ * (not built in, not supported by the kernel, or the input is not a
+ * regular file), the stdio backend is used instead.
+ *
+ * @param backend
+ * Input.  One of FS_IO_AUTO, FS_IO_STDIO, or FS_IO_URING.
+ *
+ * @return
+ * The previous backend.
+ */
+int fs_set_io_backend(const int backend)
+{
+  const int old = io_backend;
+  io_backend = backend;
+  return old;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Set the Page Cache Mode
+ *
+ * @details
+ * Chooses what the scans of the input leave in the OS page cache.
+ * FS_CACHE_DEFAULT leaves it to the kernel.  FS_CACHE_KEEP tells the
+ * kernel the file is read sequentially and asks for the blocks ahead of
+ * the scan to be read in, so that a second pass over the same file (as
+ * in the exact sampler) finds them cached.  FS_CACHE_DROP gives each
+ * block back to the page cache once it has been read, so that a large
+ * scan doesn't push out the working sets of other processes.
+ * FS_CACHE_DIRECT reads with O_DIRECT, bypassing the page cache
+ * entirely, where the io_uring backend is used and the filesystem
+ * supports it; elsewhere it acts as FS_CACHE_DROP.
+ * 
+ * The hints are given with posix_fadvise(), so they do nothing on
+ * systems without it.
+ *
+ * @param mode
+ * Input.  One of FS_CACHE_DEFAULT, FS_CACHE_KEEP, FS_CACHE_DROP, or
+ * FS_CACHE_DIRECT.
+ *
+ * @return
+ * The previous mode.
+ */
+int fs_set_cache_mode(const int mode)
+{
+  const int old = cache_mode;
+  cache_mode = mode;
+  return old;
+}
+
+
+
+int fs_get_cache_mode()
+{
+  return cache_mode;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// io_uring
+// -----------------------------------------------------------------------------
+
+#ifdef FS_HAVE_IO_URING
+
+struct uring_t
+{
+  int fd;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+  
+  void *sq_ptr;
+  void *cq_ptr;
+  size_t sq_len;
+  size_t cq_len;
+  size_t sqes_len;
+  
+  struct iovec iov[FS_URING_DEPTH];
+  int res[FS_URING_DEPTH];
+  bool done[FS_URING_DEPTH];
+  bool pending[FS_URING_DEPTH];
+};
+
+
+
+static inline int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+
+
+static void uring_free(uring_t *ring)
+{
+  if (ring->sqes && ring->sqes != MAP_FAILED)
+    munmap(ring->sqes, ring->sqes_len);
+  if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr)
+    munmap(ring->cq_ptr, ring->cq_len);
+  if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED)
+    munmap(ring->sq_ptr, ring->sq_len);
+  if (ring->fd >= 0)
+    close(ring->fd);
+  
+  free(ring);
+}
+
+
+
+static uring_t* uring_init()
+{
+  struct io_uring_params p;
+  uring_t *ring = calloc(1, sizeof(*ring));
+  if (ring == NULL)
+    return NULL;
+  
+  memset(&p, 0, sizeof(p));
+  ring->fd = sys_io_uring_setup(FS_URING_DEPTH, &p);
+  if (ring->fd < 0)
+  {
+    free(ring);
+    return NULL;
+  }
+  
+  ring->sq_len = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+  ring->cq_len = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if (ring->cq_len > ring->sq_len)
+      ring->sq_len = ring->cq_len;
+    ring->cq_len = ring->sq_len;
+  }
+  
+  ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED)
+    goto fail;
+  
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    ring->cq_ptr = ring->sq_ptr;
+  else
+  {
+    ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED)
+      goto fail;
+  }
+  
+  ring->sqes_len = p.sq_entries*sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED)
+    goto fail;
+  
+  ring->sq_tail = (unsigned*) ((char*) ring->sq_ptr + p.sq_off.tail);
+  ring->sq_mask = (unsigned*) ((char*) ring->sq_ptr + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned*) ((char*) ring->sq_ptr + p.sq_off.array);
+  ring->cq_head = (unsigned*) ((char*) ring->cq_ptr + p.cq_off.head);
+  ring->cq_tail = (unsigned*) ((char*) ring->cq_ptr + p.cq_off.tail);
+  ring->cq_mask = (unsigned*) ((char*) ring->cq_ptr + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*) ((char*) ring->cq_ptr + p.cq_off.cqes);
+  
+  return ring;
+  
+fail:
+  uring_free(ring);
+  return NULL;
+}
+
+
+
+static int uring_submit_read(uring_t *ring, const int fd, const int id, char *buf, const size_t len, const uint64_t offset)
+{
+  struct io_uring_sqe *sqe;
+  const unsigned tail = *ring->sq_tail;
+  const unsigned idx = tail & *ring->sq_mask;
+  int ret;
+  
+  ring->iov[id].iov_base = buf;
+  ring->iov[id].iov_len = len;
+  ring->done[id] = false;
+  ring->pending[id] = true;
+  
+  sqe = ring->sqes + idx;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t) (uintptr_t) (ring->iov + id);
+  sqe->len = 1;
+  sqe->off = offset;
+  sqe->user_data = (uint64_t) id;
+  
+  ring->sq_array[idx] = idx;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  
+  do
+    ret = sys_io_uring_enter(ring->fd, 1, 0, 0);
+  while (ret < 0 && errno == EINTR);
+  
+  return (ret == 1) ? 0 : READ_FAIL;
+}
+
+
+
+// block until request `id` has completed
+static int uring_wait(uring_t *ring, const int id)
+{
+  while (!ring->done[id])
+  {
+    unsigned head = *ring->cq_head;
+    
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      int ret = sys_io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+      if (ret < 0 && errno != EINTR)
+        return READ_FAIL;
+      
+      continue;
+    }
+    
+    struct io_uring_cqe *cqe = ring->cqes + (head & *ring->cq_mask);
+    const int done_id = (int) cqe->user_data;
+    ring->res[done_id] = cqe->res;
+    ring->done[done_id] = true;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+  }
+  
+  return 0;
+}
+
+
+
+static int reader_uring_submit(reader_t *r, const int id)
+{
+  int ret;
+  uint64_t len = r->filesize - r->submit_offset;
+  if (len > FS_BLOCKLEN)
+    len = FS_BLOCKLEN;
+  
+  // O_DIRECT reads whole sectors; the one at the end of the file comes back
+  // short
+  if (r->direct)
+    ret = uring_submit_read(r->ring, r->fd, id, r->buf + (size_t)id*FS_BLOCKLEN, (size_t) ((len + FS_DIRECT_ALIGN - 1) & ~((uint64_t) FS_DIRECT_ALIGN - 1)), r->submit_offset);
+  else
+    ret = uring_submit_read(r->ring, r->fd, id, r->buf + (size_t)id*FS_BLOCKLEN, (size_t) len, r->submit_offset);
+  
+  if (ret)
+    return ret;
+  
+  r->submit_offset += len;
+  r->inflight++;
+  return 0;
+}
+
+
+
+static int reader_uring_open(reader_t *r, const char *file)
+{
+  struct stat sb;
+  
+  // not every filesystem takes O_DIRECT
+  if (cache_mode == FS_CACHE_DIRECT)
+  {
+    r->fd = open(file, O_RDONLY | O_DIRECT);
+    r->direct = (r->fd >= 0);
+  }
+  
+  if (r->fd < 0)
+    r->fd = open(file, O_RDONLY);
+  if (r->fd < 0)
+    return READ_FAIL;
+  
+  // reads at explicit offsets only make sense for regular files
+  if (fstat(r->fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+    goto fallback;
+  
+  r->ring = uring_init();
+  if (r->ring == NULL)
+    goto fallback;
+  
+  if (posix_memalign((void**) &r->buf, FS_DIRECT_ALIGN, (size_t)FS_URING_DEPTH * FS_BLOCKLEN) != 0)
+    r->buf = NULL;
+  
+  if (r->buf == NULL)
+  {
+    uring_free(r->ring);
+    r->ring = NULL;
+    close(r->fd);
+    return MALLOC_FAIL;
+  }
+  
+  r->filesize = (uint64_t) sb.st_size;
+  r->backend = FS_IO_URING;
+  cache_start(r->fd);
+  
+  for (int i=0; i<FS_URING_DEPTH && r->submit_offset < r->filesize; i++)
+  {
+    if (reader_uring_submit(r, i))
+      return READ_FAIL;
+  }
+  
+  return 0;
+  
+fallback:
+  close(r->fd);
+  r->fd = -1;
+  r->direct = false;
+  return FS_IO_STDIO;
+}
+
+
+
+static int reader_uring_fill(reader_t *r)
+{
+  int ret;
+  int id;
+  size_t want;
+  
+  // the previously handed out buffer is free again
+  if (r->cur >= 0 && r->submit_offset < r->filesize)
+  {
+    ret = reader_uring_submit(r, r->cur);
+    if (ret)
+      return ret;
+  }
+  r->cur = -1;
+  
+  if (r->inflight == 0)
+    return 0;
+  
+  id = r->head;
+  ret = uring_wait(r->ring, id);
+  if (ret || r->ring->res[id] < 0)
+    return READ_FAIL;
+  
+  r->ring->pending[id] = false;
+  r->inflight--;
+  
+  r->block = r->buf + (size_t)id*FS_BLOCKLEN;
+  r->blocklen = (size_t) r->ring->res[id];
+  r->nreads++;
+  
+  // short read; finish it synchronously, and without O_DIRECT, as the rest
+  // needn't be aligned
+  want = r->ring->iov[id].iov_len;
+  if (want > r->filesize - r->block_offset)
+    want = (size_t) (r->filesize - r->block_offset);
+  
+  if (r->blocklen > want)
+    r->blocklen = want;
+  
+  if (r->blocklen < want && r->direct)
+  {
+    fcntl(r->fd, F_SETFL, fcntl(r->fd, F_GETFL) & ~O_DIRECT);
+    r->direct = false;
+  }
+  
+  while (r->blocklen < want)
+  {
+    ssize_t n = pread(r->fd, r->block + r->blocklen, want - r->blocklen, (off_t) (r->block_offset + r->blocklen));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return READ_FAIL;
+    
+    r->blocklen += (size_t) n;
+    r->nreads++;
+  }
+  
+  r->cur = id;
+  r->head = (id + 1) % FS_URING_DEPTH;
+  
+  return 1;
+}
+
+#endif
+
+
+
+// -----------------------------------------------------------------------------
+// interface
+// -----------------------------------------------------------------------------
+
+/**
+ * @file
+ * @brief
+ * Open a Reader
+ *
+ * @param r
+ * Output, passed by reference.  The reader to initialize.
+ * @param file
+ * Input.  Absolute path to the file to read.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int reader_open(reader_t *r, const char *file)
+{
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+  r->cur = -1;
+  r->backend = FS_IO_STDIO;
+  
+#ifdef FS_HAVE_IO_URING
+  if (io_backend != FS_IO_STDIO)
+  {
+    int ret = reader_uring_open(r, file);
+    if (ret != FS_IO_STDIO)
+    {
+      if (ret)
+        reader_close(r);
+      
+      return ret;
+    }
+  }
+#endif
+  
+  r->fp = fopen(file, "r");
+  if (!r->fp)
+    return READ_FAIL;
+  
+  cache_start(fileno(r->fp));
+  
+  // room for a partial line and a block behind it; see reader_line()
+  r->buf = malloc(2*FS_BLOCKLEN);
+  r->bufsize = 2*FS_BLOCKLEN;
+  if (r->buf == NULL)
+  {
+    fclose(r->fp);
+    r->fp = NULL;
+    return MALLOC_FAIL;
+  }
+  
+  return 0;
+}
+
+
+
+// The blocks before the current one are done with, and (with io_uring) the
+// ones in flight are already being read, so the hint is for the one after
+static inline void reader_cache(reader_t *r, const int fd, const uint64_t ahead)
+{
+  cache_done(fd, r->cache_offset, r->block_offset - r->cache_offset);
+  r->cache_offset = r->block_offset;
+  
+  cache_ahead(fd, ahead, FS_BLOCKLEN);
+}
+
+
+
+static inline int reader_fill(reader_t *r)
+{
+  r->block_offset += r->blocklen;
+  r->blocklen = 0;
+  r->pos = 0;
+  
+#ifdef FS_HAVE_IO_URING
+  if (r->backend == FS_IO_URING)
+  {
+    int ret = reader_uring_fill(r);
+    r->bytes += r->blocklen;
+    reader_cache(r, r->fd, r->submit_offset);
+    return ret;
+  }
+#endif
+  
+  reader_cache(r, fileno(r->fp), r->block_offset + FS_BLOCKLEN);
+  r->block = r->buf;
+  r->blocklen = fread(r->buf, sizeof(*r->buf), FS_BLOCKLEN, r->fp);
+  r->nreads++;
+  r->bytes += r->blocklen;
+  
+  if (r->blocklen == 0)
+    return ferror(r->fp) ? READ_FAIL : 0;
+  
+  return 1;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Read the Next Block
+ *
+ * @details
+ * Hands out the rest of the current block, or the next block of the
+ * file if the current one is used up.
+ *
+ * @param r
+ * Input/output.  An open reader.
+ * @param block,len
+ * Output, passed by reference.  On return of 1, the block and its
+ * length.
+ *
+ * @return
+ * 1 if a block was read, 0 at the end of the file, and an error code
+ * otherwise.
+ */
+int reader_next(reader_t *r, char **block, size_t *len)
+{
+  if (r->pos == r->blocklen)
+  {
+    int ret = reader_fill(r);
+    if (ret <= 0)
+      return ret;
+  }
+  
+  *block = r->block + r->pos;
+  *len = r->blocklen - r->pos;
+  r->pos = r->blocklen;
+  
+  return 1;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Read the Next Line (Piece)
+ *
+ * @details
+ * Hands out the next line, newline included.  A line that straddles
+ * the end of a block is handed out in pieces, so callers should check
+ * for the trailing newline.  This suits loops that stream lines through
+ * without looking at them; see reader_line() for whole lines.
+ *
+ * @param r
+ * Input/output.  An open reader.
+ * @param line,len
+ * Output, passed by reference.  On return of 1, the line (or piece of
+ * it) and its length.  The line is not NUL terminated.
+ *
+ * @return
+ * 1 if a line was read, 0 at the end of the file, and an error code
+ * otherwise.
+ */
+int reader_getline(reader_t *r, char **line, size_t *len)
+{
+  char *start;
+  char *nl;
+  size_t avail;
+  
+  if (r->pos == r->blocklen)
+  {
+    int ret = reader_fill(r);
+    if (ret <= 0)
+      return ret;
+  }
+  
+  start = r->block + r->pos;
+  avail = r->blocklen - r->pos;
+  nl = memchr(start, '\n', avail);
+  
+  *line = start;
+  *len = nl ? (size_t) (nl - start + 1) : avail;
+  r->pos += *len;
+  
+  return 1;
+}
+
+
+
+// stdio, for a line that runs past the end of buf: the partial line is moved
+// to the start of buf, and the next block is read in behind it; buf doubles
+// if there isn't room for both
+static int reader_line_stdio(reader_t *r, char **line, size_t *len)
+{
+  while (true)
+  {
+    const size_t rem = r->blocklen - r->pos;
+    size_t n;
+    char *nl;
+    
+    if (r->pos > 0 && rem > 0)
+      memmove(r->buf, r->buf + r->pos, rem);
+    
+    r->block_offset += r->pos;
+    r->pos = 0;
+    r->blocklen = rem;
+    
+    // reads stay whole blocks, so they stay aligned in the file and the
+    // working set stays small
+    if (rem + FS_BLOCKLEN > r->bufsize)
+    {
+      char *tmp = realloc(r->buf, 2*r->bufsize);
+      if (tmp == NULL)
+        return MALLOC_FAIL;
+      
+      r->buf = tmp;
+      r->bufsize *= 2;
+    }
+    
+    r->block = r->buf;
+    n = fread(r->buf + rem, sizeof(*r->buf), FS_BLOCKLEN, r->fp);
+    r->nreads++;
+    r->bytes += n;
+    r->blocklen += n;
+    
+    if (n == 0)
+    {
+      if (ferror(r->fp))
+        return READ_FAIL;
+      else if (rem == 0)
+        return 0;
+      
+      // last line of the file, without a newline
+      *len = rem;
+      break;
+    }
+    
+    nl = memchr(r->buf + rem, '\n', n);
+    if (nl)
+    {
+      *len = (size_t) (nl - r->buf + 1);
+      break;
+    }
+  }
+  
+  *line = r->buf;
+  r->line_offset = r->block_offset;
+  r->pos = *len;
+  return 1;
+}
+
+
+
+// io_uring, for a line that runs past the end of the block: its pieces are
+// copied into the arena
+static int reader_line_arena(reader_t *r, char **line, size_t *len)
+{
+  int ret;
+  char *nl = NULL;
+  size_t piece = r->blocklen - r->pos;
+  size_t n = 0;
+  
+  r->line_offset = r->block_offset + r->pos;
+  
+  while (true)
+  {
+    if (piece > 0)
+    {
+      if (n + piece > r->arena_size)
+      {
+        size_t size = (r->arena_size > 0) ? 2*r->arena_size : FS_BLOCKLEN;
+        char *tmp;
+        
+        while (size < n + piece)
+          size *= 2;
+        
+        tmp = realloc(r->arena, size);
+        if (tmp == NULL)
+          return MALLOC_FAIL;
+        
+        r->arena = tmp;
+        r->arena_size = size;
+      }
+      
+      memcpy(r->arena + n, r->block + r->pos, piece);
+      n += piece;
+      r->pos += piece;
+    }
+    
+    if (nl)
+      break;
+    
+    ret = reader_fill(r);
+    if (ret < 0)
+      return ret;
+    else if (ret == 0)
+      break;
+    
+    nl = memchr(r->block, '\n', r->blocklen);
+    piece = nl ? (size_t) (nl - r->block + 1) : r->blocklen;
+    
+    // the line starts the block
+    if (n == 0 && nl)
+    {
+      *line = r->block;
+      *len = piece;
+      r->pos = piece;
+      return 1;
+    }
+  }
+  
+  if (n == 0)
+    return 0;
+  
+  *line = r->arena;
+  *len = n;
+  return 1;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Read the Next Line
+ *
+ * @details
+ * The out-of-line part of reader_line() (see reader.h), which hands out
+ * the next whole line, newline included (the last line of the file may
+ * not have one), as a view into the reader's memory.  reader_line()
+ * handles lines within the current block itself, without copies; this
+ * is called for the rest.  With the stdio backend, a line that
+ * straddles the end of the buffer is moved to its start before the next
+ * read, and the buffer grows to hold lines longer than it.  With the
+ * io_uring backend, the pieces of such a line are copied into a
+ * separate arena that is reused from line to line.
+ *
+ * @param r
+ * Input/output.  An open reader.
+ * @param line,len
+ * Output, passed by reference.  On return of 1, the line and its
+ * length.  The line is not NUL terminated.  Its position in the file is
+ * reader_line_offset().
+ *
+ * @return
+ * 1 if a line was read, 0 at the end of the file, and an error code
+ * otherwise.
+ */
+int reader_line_refill(reader_t *r, char **line, size_t *len)
+{
+  if (r->backend == FS_IO_STDIO)
+    return reader_line_stdio(r, line, len);
+  else
+    return reader_line_arena(r, line, len);
+}
+
+
+
+const char* reader_backend_name(const reader_t *r)
+{
+  return (r->backend == FS_IO_URING) ? "io_uring" : "stdio";
+}
+
+
+
+void reader_close(reader_t *r)
+{
+#ifdef FS_HAVE_IO_URING
+  if (r->ring)
+  {
+    // the kernel may still be writing into the buffers
+    for (int id=0; id<FS_URING_DEPTH; id++)
+    {
+      if (r->ring->pending[id])
+        uring_wait(r->ring, id);
+    }
+    
+    uring_free(r->ring);
+  }
+  
+  // pages that were still being read ahead when their range was dropped
+  if (r->fd >= 0)
+  {
+    cache_done(r->fd, 0, r->block_offset + r->blocklen);
+    close(r->fd);
+  }
+#endif
+  
+  if (r->fp)
+  {
+    cache_done(fileno(r->fp), 0, r->block_offset + r->blocklen);
+    fclose(r->fp);
+  }
+  
+  free(r->buf);
+  free(r->arena);
+  r->buf = NULL;
+  r->arena = NULL;
+}
@@ -0,0 +1,170 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FILESAMPLER_READER_H_
+#define FILESAMPLER_READER_H_
+
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "filesampler.h"
+
+// Block size for the scanning loops, and the number of blocks kept in flight
+// by the io_uring backend.
+#define FS_BLOCKLEN (1 << 18)
+#define FS_URING_DEPTH 4
+
+// Alignment of the buffers, offsets and lengths of O_DIRECT reads
+#define FS_DIRECT_ALIGN 4096
+
+
+typedef struct uring_t uring_t;
+
+// Sequential block reader over one input file.  Blocks are handed out in file
+// order; a block (or line) stays valid until the next call to reader_next(),
+// reader_getline() or reader_line().
+typedef struct reader_t
+{
+  int backend;
+  FILE *fp;
+  char *buf;
+  size_t bufsize;
+  
+  // io_uring
+  uring_t *ring;
+  int fd;
+  uint64_t filesize;
+  uint64_t submit_offset;
+  int head;
+  int inflight;
+  int cur;
+  bool direct;
+  
+  // current block
+  char *block;
+  size_t blocklen;
+  size_t pos;
+  uint64_t block_offset;
+  
+  // lines that straddle two io_uring blocks are copied into the arena; the
+  // stdio backend moves them to the start of buf instead
+  char *arena;
+  size_t arena_size;
+  uint64_t line_offset;
+  
+  // the file before this offset has been given back to the page cache
+  uint64_t cache_offset;
+  
+  // counters
+  uint64_t nreads;
+  uint64_t bytes;
+} reader_t;
+
+
+int reader_open(reader_t *r, const char *file);
+int reader_next(reader_t *r, char **block, size_t *len);
+int reader_getline(reader_t *r, char **line, size_t *len);
+int reader_line_refill(reader_t *r, char **line, size_t *len);
+const char* reader_backend_name(const reader_t *r);
+int fs_get_cache_mode();
+
+// position in the file of a block (or line piece) handed out by the reader
+static inline uint64_t reader_offset(const reader_t *r, const char *p)
+{
+  return r->block_offset + (uint64_t) (p - r->block);
+}
+
+// The next whole line, newline included.  Lines within the current block are
+// handed out in place; the rest go through reader_line_refill().  Kept inline
+// so the common case costs a memchr() and no call.
+static inline int reader_line(reader_t *r, char **line, size_t *len)
+{
+  char *start = r->block + r->pos;
+  char *nl = NULL;
+  
+  if (r->pos < r->blocklen)
+    nl = memchr(start, '\n', r->blocklen - r->pos);
+  
+  if (nl)
+  {
+    *line = start;
+    *len = (size_t) (nl - start + 1);
+    r->line_offset = r->block_offset + r->pos;
+    r->pos += *len;
+    return 1;
+  }
+  
+  return reader_line_refill(r, line, len);
+}
+
+// position in the file of the last line handed out by reader_line()
+static inline uint64_t reader_line_offset(const reader_t *r)
+{
+  return r->line_offset;
+}
+
+void reader_close(reader_t *r);
+
+
+
+// Page cache hints for the cache mode; see fs_set_cache_mode().  They do
+// nothing where posix_fadvise() isn't available.
+
+// fd is about to be scanned from start to end
+static inline void cache_start(const int fd)
+{
+#ifdef POSIX_FADV_SEQUENTIAL
+  if (fs_get_cache_mode() != FS_CACHE_DEFAULT)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+// [offset, offset+len) of fd will be read soon
+static inline void cache_ahead(const int fd, const uint64_t offset, const uint64_t len)
+{
+#ifdef POSIX_FADV_WILLNEED
+  if (len > 0 && fs_get_cache_mode() == FS_CACHE_KEEP)
+    posix_fadvise(fd, (off_t) offset, (off_t) len, POSIX_FADV_WILLNEED);
+#endif
+}
+
+// [offset, offset+len) of fd has been read and won't be needed again
+static inline void cache_done(const int fd, const uint64_t offset, const uint64_t len)
+{
+#ifdef POSIX_FADV_DONTNEED
+  const int mode = fs_get_cache_mode();
+  if (len > 0 && (mode == FS_CACHE_DROP || mode == FS_CACHE_DIRECT))
+    posix_fadvise(fd, (off_t) offset, (off_t) len, POSIX_FADV_DONTNEED);
+#endif
+}
+
+
+#endif
@@ -0,0 +1,250 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// Helpers shared by the samplers.
+
+#ifndef FILESAMPLER_SAMPLER_H_
+#define FILESAMPLER_SAMPLER_H_
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "timer.h"
+
+
+#define HAS_NEWLINE ((readlen > 0) && (buf[readlen-1] == '\n'))
+
+// The output stream is given a BUFLEN sized buffer, so every flush of it is a
+// single write request to the OS.
+#define NWRITES(nbytes) (((nbytes) + BUFLEN - 1)/BUFLEN)
+
+static inline void write_buf(const char *buf, const size_t readlen, FILE *fp_write, fs_stats_t *stats)
+{
+  if (stats)
+  {
+    const double start = fs_timer_now();
+    fwrite(buf, sizeof(*buf), readlen, fp_write);
+    stats->time_write += fs_timer_now() - start;
+    stats->bytes_written += readlen;
+  }
+  else
+    fwrite(buf, sizeof(*buf), readlen, fp_write);
+}
+
+
+
+// Write the record of a line in place of the line; see fs_offset_t
+static inline void write_offset(const uint64_t line, const uint64_t offset, const uint64_t len, FILE *fp_write, fs_stats_t *stats)
+{
+  const fs_offset_t rec = {line, offset, len};
+  write_buf((const char*) &rec, sizeof(rec), fp_write, stats);
+}
+
+
+
+// Flush the outputs and add the totals of a sampling pass to stats
+static inline void finalize_stats_n(const uint64_t bytes_read, const uint64_t nreads, const char *backend, FILE **fp_write, const int nout, const double start, const double write_start, const uint64_t lines_read, const uint64_t lines_written, fs_stats_t *stats)
+{
+  uint64_t nwrites = 0;
+  double start_close;
+  
+  if (!stats)
+    return;
+  
+  for (int i=0; i<nout; i++)
+    nwrites += NWRITES((uint64_t) ftell(fp_write[i]));
+  
+  start_close = fs_timer_now();
+  for (int i=0; i<nout; i++)
+    fflush(fp_write[i]);
+  stats->time_write += fs_timer_now() - start_close;
+  
+  stats->time_sample += (start_close - start) - (stats->time_write - write_start);
+  stats->bytes_read += bytes_read;
+  stats->nreads += nreads;
+  stats->nwrites += nwrites;
+  stats->lines_read += lines_read;
+  stats->lines_written += lines_written;
+  stats->backend = backend;
+}
+
+static inline void finalize_stats(const uint64_t bytes_read, const uint64_t nreads, const char *backend, FILE *fp_write, const double start, const double write_start, const uint64_t lines_read, const uint64_t lines_written, fs_stats_t *stats)
+{
+  finalize_stats_n(bytes_read, nreads, backend, &fp_write, 1, start, write_start, lines_read, lines_written, stats);
+}
+
+
+
+static inline int read_header(reader_t *r, FILE *fp_write, uint64_t *nlines_in, uint64_t *nlines_out, fs_stats_t *stats)
+{
+  int ret;
+  char *buf;
+  size_t readlen;
+  
+  while ((ret = reader_getline(r, &buf, &readlen)) > 0)
+  {
+    write_buf(buf, readlen, fp_write, stats);
+    
+    if (HAS_NEWLINE)
+    {
+      (*nlines_in)++;
+      (*nlines_out)++;
+      break;
+    }
+  }
+  
+  return ret < 0 ? ret : 0;
+}
+
+
+
+// As read_header(), for the offsets output
+static inline int read_header_offset(reader_t *r, FILE *fp_write, uint64_t *nlines_in, uint64_t *nlines_out, fs_stats_t *stats)
+{
+  int ret;
+  char *buf;
+  size_t readlen;
+  uint64_t len = 0;
+  
+  while ((ret = reader_getline(r, &buf, &readlen)) > 0)
+  {
+    len += readlen;
+    
+    if (HAS_NEWLINE)
+    {
+      (*nlines_in)++;
+      (*nlines_out)++;
+      break;
+    }
+  }
+  
+  if (ret < 0)
+    return ret;
+  
+  if (len > 0)
+    write_offset(0, 0, len, fp_write, stats);
+  
+  return 0;
+}
+
+
+
+// 1 if the file ends in a line without a newline, which the line counts
+// don't include; 0 otherwise
+static inline uint64_t last_line_unterminated(const char *input)
+{
+  char c = '\n';
+  struct stat sb;
+  int fd = open(input, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  
+  if (fstat(fd, &sb) == 0 && sb.st_size > 0)
+  {
+    if (pread(fd, &c, 1, sb.st_size - 1) != 1)
+      c = '\n';
+  }
+  
+  close(fd);
+  return (c != '\n');
+}
+
+
+
+// The part of a line that is hashed: field number `key` (from 1) of the
+// line split on sep, or the whole line if key is 0.  The line ending (\n or
+// \r\n) is never part of it.  Missing fields are empty.
+static inline void line_key(const char *line, size_t len, const uint32_t key, const char sep, const char **k, size_t *klen)
+{
+  const char *start = line;
+  const char *end;
+  const char *s;
+  
+  if (len > 0 && line[len-1] == '\n')
+    len--;
+  if (len > 0 && line[len-1] == '\r')
+    len--;
+  
+  end = line + len;
+  
+  if (key == 0)
+  {
+    *k = line;
+    *klen = len;
+    return;
+  }
+  
+  for (uint32_t i=1; i<key; i++)
+  {
+    s = memchr(start, sep, end - start);
+    if (s == NULL)
+    {
+      *k = end;
+      *klen = 0;
+      return;
+    }
+    
+    start = s + 1;
+  }
+  
+  s = memchr(start, sep, end - start);
+  *k = start;
+  *klen = (s ? s : end) - start;
+}
+
+
+
+// pread() exactly len bytes
+static inline int pread_full(const int fd, char *buf, const size_t len, const uint64_t offset, uint64_t *nreads)
+{
+  size_t pos = 0;
+  
+  while (pos < len)
+  {
+    ssize_t n = pread(fd, buf + pos, len - pos, (off_t) (offset + pos));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return READ_FAIL;
+    
+    pos += (size_t) n;
+    (*nreads)++;
+  }
+  
+  return 0;
+}
+
+
+#endif
@@ -0,0 +1,190 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+// Block cursor over a file read with pread(), for passes that skip most of
+// the lines they pass over.
+
+#ifndef FILESAMPLER_SCAN_H_
+#define FILESAMPLER_SCAN_H_
+
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesampler.h"
+#include "linefeed.h"
+#include "reader.h"
+#include "sampler.h"
+#include "writer.h"
+
+
+typedef struct scan_t
+{
+  int fd;
+  char *buf;
+  uint64_t filesize;
+  // the loaded block, and the position in the file
+  uint64_t boff;
+  size_t blen;
+  uint64_t pos;
+  // newlines passed
+  uint64_t nlines;
+  
+  uint64_t nreads;
+  uint64_t bytes;
+} scan_t;
+
+
+
+static inline int scan_open(scan_t *x, const char *input)
+{
+  struct stat sb;
+  
+  x->fd = open(input, O_RDONLY);
+  if (x->fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(x->fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(x->fd);
+    return READ_FAIL;
+  }
+  
+  x->buf = malloc(FS_BLOCKLEN);
+  if (x->buf == NULL)
+  {
+    close(x->fd);
+    return MALLOC_FAIL;
+  }
+  
+  cache_start(x->fd);
+  
+  x->filesize = (uint64_t) sb.st_size;
+  x->boff = 0;
+  x->blen = 0;
+  x->pos = 0;
+  x->nlines = 0;
+  x->nreads = 0;
+  x->bytes = 0;
+  
+  return 0;
+}
+
+
+
+static inline void scan_close(scan_t *x)
+{
+  close(x->fd);
+  free(x->buf);
+}
+
+
+
+// Load the block starting at pos; returns 0 at the end of the file
+static inline int scan_load(scan_t *x)
+{
+  const size_t len = (x->filesize - x->pos > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (x->filesize - x->pos);
+  
+  cache_done(x->fd, x->boff, x->blen);
+  x->boff = x->pos;
+  x->blen = len;
+  if (len == 0)
+    return 0;
+  
+  if (pread_full(x->fd, x->buf, len, x->pos, &x->nreads))
+    return READ_FAIL;
+  
+  x->bytes += len;
+  return 1;
+}
+
+
+
+// Move past the next n lines, writing them if w isn't NULL.  Blocks without
+// the n'th newline are only counted.  Returns 0 if the file ended first.
+static inline int scan_skip(scan_t *x, uint64_t n, writer_t *w, fs_stats_t *stats)
+{
+  int ret;
+  
+  while (n > 0)
+  {
+    char *p;
+    size_t avail, len;
+    uint64_t nl;
+    
+    if (x->pos >= x->boff + x->blen)
+    {
+      ret = scan_load(x);
+      if (ret <= 0)
+        return ret;
+    }
+    
+    p = x->buf + (x->pos - x->boff);
+    avail = (size_t) (x->boff + x->blen - x->pos);
+    
+    if (n == 1)
+    {
+      const char *e = memchr(p, '\n', avail);
+      len = e ? (size_t) (e - p + 1) : avail;
+      if (e)
+      {
+        x->nlines++;
+        n = 0;
+      }
+    }
+    else if ((nl = linefeedcount(p, avail)) >= n)
+    {
+      len = (size_t) linefeed_find(p, avail, n) + 1;
+      x->nlines += n;
+      n = 0;
+    }
+    else
+    {
+      len = avail;
+      x->nlines += nl;
+      n -= nl;
+    }
+    
+    if (w)
+    {
+      ret = writer_range(w, p, len, x->pos, stats);
+      if (ret)
+        return ret;
+    }
+    
+    x->pos += len;
+  }
+  
+  return 1;
+}
+
+
+#endif
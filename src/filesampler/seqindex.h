@@ -0,0 +1,95 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FILESAMPLER_SEQINDEX_H_
+#define FILESAMPLER_SEQINDEX_H_
+
+
+#include <stdint.h>
+
+#include "utils.h"
+
+
+// Vitter's Method A (ACM TOMS 13(1), 1987): each draw gives the number of
+// lines to skip before the next sampled one
+typedef struct seqindex_t
+{
+  // lines left to sample, out of the N starting at line `next`
+  uint64_t n;
+  uint64_t N;
+  uint64_t next;
+} seqindex_t;
+
+
+
+static inline void seqindex_init(seqindex_t *s, const uint64_t first, const uint64_t N, const uint64_t n)
+{
+  s->n = (n < N) ? n : N;
+  s->N = N;
+  s->next = first;
+}
+
+
+
+// Fill samp with up to len more (sorted) line numbers; returns how many
+static inline uint64_t seqindex_fill(seqindex_t *s, uint64_t *samp, const uint64_t len)
+{
+  uint64_t i = 0;
+  
+  while (i < len && s->n > 0)
+  {
+    uint64_t skip = 0;
+    
+    if (s->n == 1)
+      skip = (uint64_t) (s->N * RUNIF);
+    else
+    {
+      const double v = RUNIF;
+      double top = (double) (s->N - s->n);
+      double nreal = (double) s->N;
+      double quot = top / nreal;
+      
+      while (quot > v)
+      {
+        skip++;
+        top--;
+        nreal--;
+        quot *= top / nreal;
+      }
+    }
+    
+    samp[i++] = s->next + skip;
+    s->next += skip + 1;
+    s->N -= skip + 1;
+    s->n--;
+  }
+  
+  return i;
+}
+
+
+#endif
@@ -0,0 +1,235 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <math.h>
+#include <string.h>
+
+#include "error.h"
+#include "sketch.h"
+
+
+// -----------------------------------------------------------------------------
+// HyperLogLog
+// -----------------------------------------------------------------------------
+
+void fs_hll_merge(fs_hll_t *restrict a, const fs_hll_t *restrict b)
+{
+  for (int i=0; i<FS_HLL_M; i++)
+  {
+    if (b->reg[i] > a->reg[i])
+      a->reg[i] = b->reg[i];
+  }
+}
+
+
+
+double fs_hll_estimate(const fs_hll_t *hll)
+{
+  const double m = (double) FS_HLL_M;
+  const double alpha = 0.7213 / (1. + 1.079/m);
+  double sum = 0.;
+  int zeros = 0;
+  double est;
+  
+  for (int i=0; i<FS_HLL_M; i++)
+  {
+    sum += ldexp(1., -hll->reg[i]);
+    zeros += (hll->reg[i] == 0);
+  }
+  
+  est = alpha * m * m / sum;
+  
+  // small range correction (linear counting); with 64-bit hashes there is
+  // no need for the large range one
+  if (est <= 2.5*m && zeros > 0)
+    est = m * log(m / zeros);
+  
+  return est;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Count-Min
+// -----------------------------------------------------------------------------
+
+void fs_cms_init(fs_cms_t *cms, const int k)
+{
+  memset(cms->count, 0, sizeof(cms->count));
+  cms->k = (k < FS_TOPK_MAX) ? k : FS_TOPK_MAX;
+  cms->ntop = 0;
+  cms->topmin = 0;
+}
+
+
+
+void fs_cms_free(fs_cms_t *cms)
+{
+  for (int i=0; i<cms->ntop; i++)
+    free(cms->top[i].key);
+  
+  cms->ntop = 0;
+}
+
+
+
+static void topk_update_min(fs_cms_t *cms)
+{
+  uint64_t min = UINT64_MAX;
+  for (int i=0; i<cms->ntop; i++)
+  {
+    if (cms->top[i].count < min)
+      min = cms->top[i].count;
+  }
+  
+  cms->topmin = min;
+}
+
+
+
+// offer a key with estimated count est to the top list
+static int topk_offer(fs_cms_t *cms, const uint64_t h, const uint64_t est, const char *key, const size_t keylen)
+{
+  int slot;
+  char *copy;
+  
+  if (cms->k == 0)
+    return 0;
+  
+  if (cms->ntop == cms->k && est <= cms->topmin)
+    return 0;
+  
+  for (int i=0; i<cms->ntop; i++)
+  {
+    if (cms->top[i].hash == h)
+    {
+      if (est > cms->top[i].count)
+      {
+        cms->top[i].count = est;
+        if (cms->ntop == cms->k)
+          topk_update_min(cms);
+      }
+      
+      return 0;
+    }
+  }
+  
+  copy = malloc(keylen + 1);
+  if (copy == NULL)
+    return MALLOC_FAIL;
+  
+  memcpy(copy, key, keylen);
+  copy[keylen] = '\0';
+  
+  if (cms->ntop < cms->k)
+    slot = cms->ntop++;
+  else
+  {
+    slot = 0;
+    for (int i=1; i<cms->ntop; i++)
+    {
+      if (cms->top[i].count < cms->top[slot].count)
+        slot = i;
+    }
+    
+    free(cms->top[slot].key);
+  }
+  
+  cms->top[slot].hash = h;
+  cms->top[slot].count = est;
+  cms->top[slot].key = copy;
+  
+  if (cms->ntop == cms->k)
+    topk_update_min(cms);
+  
+  return 0;
+}
+
+
+
+int fs_cms_add(fs_cms_t *cms, const uint64_t h, const char *key, const size_t keylen)
+{
+  uint64_t est = UINT64_MAX;
+  
+  for (int d=0; d<FS_CMS_DEPTH; d++)
+  {
+    const uint64_t c = ++cms->count[d][fs_cms_index(h, d)];
+    if (c < est)
+      est = c;
+  }
+  
+  return topk_offer(cms, h, est, key, keylen);
+}
+
+
+
+static int topk_comp(const void *a, const void *b)
+{
+  const uint64_t ca = ((const fs_topk_t*) a)->count;
+  const uint64_t cb = ((const fs_topk_t*) b)->count;
+  return (ca < cb) - (ca > cb);
+}
+
+// Refresh the counts of the top keys and sort them by decreasing count
+void fs_cms_sort(fs_cms_t *cms)
+{
+  for (int i=0; i<cms->ntop; i++)
+    cms->top[i].count = fs_cms_query(cms, cms->top[i].hash);
+  
+  qsort(cms->top, cms->ntop, sizeof(*cms->top), topk_comp);
+  
+  if (cms->ntop == cms->k)
+    topk_update_min(cms);
+}
+
+
+
+// Add b into a; b's top keys are moved to a (or freed), so b is left empty
+int fs_cms_merge(fs_cms_t *restrict a, fs_cms_t *restrict b)
+{
+  int ret = 0;
+  
+  for (int d=0; d<FS_CMS_DEPTH; d++)
+  {
+    for (int i=0; i<FS_CMS_WIDTH; i++)
+      a->count[d][i] += b->count[d][i];
+  }
+  
+  // the counts of a's candidates have changed too
+  fs_cms_sort(a);
+  
+  for (int i=0; i<b->ntop && !ret; i++)
+  {
+    const fs_topk_t *t = b->top + i;
+    ret = topk_offer(a, t->hash, fs_cms_query(a, t->hash), t->key, strlen(t->key));
+  }
+  
+  fs_cms_free(b);
+  fs_cms_sort(a);
+  
+  return ret;
+}
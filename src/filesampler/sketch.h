@@ -0,0 +1,102 @@
+// This file is free and unencumbered software released into the public domain.
+// You may modify it for any purpose with or without attribution.
+// See the Unlicense specification for full details http://unlicense.org/
+
+#ifndef FILESAMPLER_SKETCH_H_
+#define FILESAMPLER_SKETCH_H_
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Sketches of the lines of a file, built from 64-bit hashes (see hash.h).
+// All of them can be built in pieces (e.g. one per thread) and merged.
+
+
+// HyperLogLog distinct counter with 2^FS_HLL_P registers; the standard
+// error is about 1.04/sqrt(2^FS_HLL_P), so 0.8%.
+#define FS_HLL_P 14
+#define FS_HLL_M (1 << FS_HLL_P)
+
+typedef struct fs_hll_t
+{
+  uint8_t reg[FS_HLL_M];
+} fs_hll_t;
+
+static inline void fs_hll_add(fs_hll_t *hll, const uint64_t h)
+{
+  const uint32_t idx = (uint32_t) (h >> (64 - FS_HLL_P));
+  // the sentinel bit bounds the rank by 64 - FS_HLL_P + 1
+  uint64_t w = (h << FS_HLL_P) | ((uint64_t) 1 << (FS_HLL_P - 1));
+  uint8_t rank = 1;
+  
+#if defined(__GNUC__)
+  rank += (uint8_t) __builtin_clzll(w);
+#else
+  while (!(w & ((uint64_t) 1 << 63)))
+  {
+    rank++;
+    w <<= 1;
+  }
+#endif
+  
+  if (rank > hll->reg[idx])
+    hll->reg[idx] = rank;
+}
+
+
+// Count-Min sketch of the key frequencies, plus the FS_TOPK_MAX keys with
+// the largest estimated counts seen so far.
+#define FS_CMS_DEPTH 4
+#define FS_CMS_WIDTH 4096
+#define FS_TOPK_MAX 100
+
+typedef struct fs_topk_t
+{
+  uint64_t hash;
+  uint64_t count;
+  char *key;
+} fs_topk_t;
+
+typedef struct fs_cms_t
+{
+  uint64_t count[FS_CMS_DEPTH][FS_CMS_WIDTH];
+  
+  int k;
+  int ntop;
+  // smallest count in top, once it is full
+  uint64_t topmin;
+  fs_topk_t top[FS_TOPK_MAX];
+} fs_cms_t;
+
+static inline uint32_t fs_cms_index(const uint64_t h, const int d)
+{
+  return ((uint32_t) h + (uint32_t) d * (uint32_t) (h >> 32)) & (FS_CMS_WIDTH - 1);
+}
+
+static inline uint64_t fs_cms_query(const fs_cms_t *cms, const uint64_t h)
+{
+  uint64_t est = cms->count[0][fs_cms_index(h, 0)];
+  for (int d=1; d<FS_CMS_DEPTH; d++)
+  {
+    const uint64_t c = cms->count[d][fs_cms_index(h, d)];
+    if (c < est)
+      est = c;
+  }
+  
+  return est;
+}
+
+
+// sketch.c
+void fs_hll_merge(fs_hll_t *restrict a, const fs_hll_t *restrict b);
+double fs_hll_estimate(const fs_hll_t *hll);
+
+void fs_cms_init(fs_cms_t *cms, const int k);
+void fs_cms_free(fs_cms_t *cms);
+int fs_cms_add(fs_cms_t *cms, const uint64_t h, const char *key, const size_t keylen);
+void fs_cms_sort(fs_cms_t *cms);
+int fs_cms_merge(fs_cms_t *restrict a, fs_cms_t *restrict b);
+
+
+#endif
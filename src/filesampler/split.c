@@ -0,0 +1,232 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filesampler.h"
+#include "hash.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+
+
+/**
+ * @file
+ * @brief 
+ * Split File Sampler
+ *
+ * @details
+ * This function partitions the lines of an input file into several
+ * disjoint output files in a single pass, e.g. for train/test/validation
+ * splits.  Each line is written to output i with probability p[i], and
+ * to no output with probability 1 - sum(p).  A single uniform draw u
+ * per line picks the output: the first i with u < p[0] + ... + p[i].
+ * 
+ * The draw comes either from the RNG or, if hash=true, from a hash of
+ * the line's contents (without its line ending) and the seed.  Hashed
+ * splits do not depend on the RNG state or on the order of the lines,
+ * so the same line always lands in the same output, even across files.
+ * Duplicate lines always land together.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).  If so, it is written to every output.
+ * @param nout
+ * Input.  Number of outputs.
+ * @param p
+ * Input.  Array of length nout; the proportion of lines to write to
+ * each output.  They must be non-negative and sum to at most 1.
+ * @param hash
+ * Input.  Use the hash of each line instead of the RNG.
+ * @param seed
+ * Input.  Seed of the hash.  Ignored if hash=false.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param outputs
+ * Input.  Array of length nout; absolute paths to the output files.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_split(const bool verbose, const bool header, const int nout, const double *p, const bool hash, const uint64_t seed, const char *input, const char **outputs, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  FILE **fp_write;
+  double *cum;
+  uint64_t *nlines_out;
+  char *line;
+  size_t len;
+  uint64_t nlines_in = 0;
+  uint64_t nlines_total = 0;
+  double sum = 0.;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  if (nout < 1)
+    return INVALID_PROB;
+  
+  for (int i=0; i<nout; i++)
+  {
+    if (p[i] < 0.)
+      return INVALID_PROB;
+    
+    sum += p[i];
+  }
+  
+  // allow for rounding in p's that are meant to sum to 1
+  if (sum > 1. + 1e-12)
+    return INVALID_PROB;
+  
+  cum = malloc(nout * sizeof(*cum));
+  nlines_out = calloc(nout, sizeof(*nlines_out));
+  fp_write = calloc(nout, sizeof(*fp_write));
+  if (cum == NULL || nlines_out == NULL || fp_write == NULL)
+  {
+    free(cum);
+    free(nlines_out);
+    free(fp_write);
+    return MALLOC_FAIL;
+  }
+  
+  for (int i=0; i<nout; i++)
+    cum[i] = (i > 0 ? cum[i-1] : 0.) + p[i];
+  
+  ret = reader_open(&r, input);
+  if (ret)
+  {
+    free(cum);
+    free(nlines_out);
+    free(fp_write);
+    return ret;
+  }
+  
+  for (int i=0; i<nout; i++)
+  {
+    fp_write[i] = fopen(outputs[i], "w");
+    if (!fp_write[i])
+    {
+      ret = WRITE_FAIL;
+      goto cleanup;
+    }
+    
+    setvbuf(fp_write[i], NULL, _IOFBF, BUFLEN);
+  }
+  
+  if (header)
+  {
+    ret = reader_line(&r, &line, &len);
+    if (ret < 0)
+      goto cleanup;
+    
+    if (ret)
+    {
+      for (int i=0; i<nout; i++)
+      {
+        write_buf(line, len, fp_write[i], stats);
+        nlines_out[i]++;
+      }
+      
+      nlines_in++;
+      nlines_total += nout;
+    }
+  }
+  
+  STARTRNG;
+  
+  while ((ret = reader_line(&r, &line, &len)) > 0)
+  {
+    double u;
+    int i;
+    
+    if ((nlines_in % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    nlines_in++;
+    
+    if (hash)
+    {
+      const char *key;
+      size_t keylen;
+      line_key(line, len, 0, 0, &key, &keylen);
+      u = fs_hash_unif(fs_hash(key, keylen, seed));
+    }
+    else
+      u = RUNIF;
+    
+    for (i=0; i<nout && u >= cum[i]; i++)
+      ;
+    
+    if (i < nout)
+    {
+      write_buf(line, len, fp_write[i], stats);
+      nlines_out[i]++;
+      nlines_total++;
+    }
+  }
+  
+  ENDRNG;
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  ret = 0;
+  finalize_stats_n(r.bytes, r.nreads, reader_backend_name(&r), fp_write, nout, start, write_start, nlines_in, nlines_total, stats);
+  
+  if (verbose)
+  {
+    for (int i=0; i<nout; i++)
+      PRINTFUN("Wrote %llu lines to output %d.\n", nlines_out[i], i+1);
+    
+    PRINTFUN("Read %llu line file.\n", nlines_in);
+  }
+  
+  
+  cleanup:
+    reader_close(&r);
+    for (int i=0; i<nout; i++)
+    {
+      if (fp_write[i])
+        fclose(fp_write[i]);
+    }
+    
+    free(cum);
+    free(nlines_out);
+    free(fp_write);
+  
+  return ret;
+}
@@ -0,0 +1,83 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <string.h>
+
+#include "filesampler.h"
+#include "utils.h"
+
+
+void fs_stats_init(fs_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+
+
+static inline double mb_per_sec(const uint64_t bytes, const double time)
+{
+  if (time <= 0.)
+    return 0.;
+  
+  return (double) bytes / 1e6 / time;
+}
+
+/**
+ * @file
+ * @brief
+ * Print Instrumentation
+ *
+ * @details
+ * Prints the per-phase timings, byte/line counters, and the resulting
+ * throughput collected in an fs_stats_t object with PRINTFUN.
+ *
+ * @param stats
+ * Input.  The stats object, filled in by one or more of the core
+ * functions.
+ */
+void fs_stats_print(const fs_stats_t *stats)
+{
+  const double total = stats->time_count + stats->time_index +
+    stats->time_sort + stats->time_sample + stats->time_write;
+  
+  PRINTFUN("## Time (seconds)\n");
+  PRINTFUN("count:   %.4f\n", stats->time_count);
+  PRINTFUN("index:   %.4f\n", stats->time_index);
+  PRINTFUN("sort:    %.4f\n", stats->time_sort);
+  PRINTFUN("sample:  %.4f\n", stats->time_sample);
+  PRINTFUN("write:   %.4f\n", stats->time_write);
+  PRINTFUN("total:   %.4f\n", total);
+  PRINTFUN("## I/O\n");
+  PRINTFUN("read:    %llu bytes, %llu lines, %llu calls (%.2f MB/s)\n",
+    (unsigned long long) stats->bytes_read, (unsigned long long) stats->lines_read,
+    (unsigned long long) stats->nreads, mb_per_sec(stats->bytes_read, total));
+  PRINTFUN("written: %llu bytes, %llu lines, %llu calls\n",
+    (unsigned long long) stats->bytes_written, (unsigned long long) stats->lines_written,
+    (unsigned long long) stats->nwrites);
+  PRINTFUN("kernel:  %s\n", stats->kernel ? stats->kernel : "none");
+  PRINTFUN("backend: %s\n", stats->backend ? stats->backend : "none");
+}
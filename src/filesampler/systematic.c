@@ -0,0 +1,172 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+
+
+/**
+ * @file
+ * @brief 
+ * Systematic File Sampler
+ *
+ * @details
+ * This function takes an input file and retains every k'th line,
+ * starting at a line chosen uniformly at random from the first k.
+ * Each line is retained with probability 1/k as with the proportional
+ * sampler, but the retained lines are evenly spread over the file and
+ * only one random number is drawn.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line (as in a
+ * csv).
+ * @param nskip
+ * Input.  Number of lines to skip.  If header=true and nskip>0, then
+ * the number of lines skipped applies to post-header lines only.
+ * @param k
+ * Input.  The sampling interval; must be positive.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param output
+ * Input.  Absolute path to output file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ * 
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_systematic(const bool verbose, const bool header, uint32_t nskip, const uint64_t k, const char *input, const char *output, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  FILE *fp_write;
+  char *buf;
+  size_t readlen;
+  bool should_write = false;
+  bool singleread = true;
+  uint64_t next;
+  uint64_t current_line = 0;
+  uint64_t nlines_in = 0, nlines_out = 0;
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  if (k == 0)
+    return INVALID_INTERVAL;
+  
+  ret = reader_open(&r, input);
+  if (ret)
+    return ret;
+  
+  fp_write = fopen(output, "w");
+  if (!fp_write)
+  {
+    reader_close(&r);
+    return WRITE_FAIL;
+  }
+  
+  setvbuf(fp_write, NULL, _IOFBF, BUFLEN);
+  
+  if (header)
+  {
+    ret = read_header(&r, fp_write, &nlines_in, &nlines_out, stats);
+    if (ret)
+      goto cleanup;
+  }
+  
+  STARTRNG;
+  next = (uint64_t) (k*RUNIF);
+  ENDRNG;
+  
+  while ((ret = reader_getline(&r, &buf, &readlen)) > 0)
+  {
+    if (singleread)
+    {
+      if ((nlines_in % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+      {
+        ret = USER_INTERRUPT;
+        goto cleanup;
+      }
+      
+      if (nskip)
+        should_write = false;
+      else
+      {
+        should_write = (current_line == next);
+        if (should_write)
+          next += k;
+      }
+    }
+    
+    if (should_write)
+      write_buf(buf, readlen, fp_write, stats);
+    
+    if (HAS_NEWLINE)
+    {
+      nlines_in++;
+      singleread = true;
+      
+      if (nskip)
+        nskip--;
+      else
+      {
+        current_line++;
+        nlines_out += should_write;
+      }
+    }
+    else
+      singleread = false;
+  }
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  // last line of the file had no trailing newline
+  if (!singleread && should_write)
+    nlines_out++;
+  
+  ret = 0;
+  finalize_stats(r.bytes, r.nreads, reader_backend_name(&r), fp_write, start, write_start, nlines_in, nlines_out, stats);
+  
+  if (verbose)
+    PRINTFUN("Read %llu lines (%.5f%%) of %llu line file.\n", nlines_out, (double) nlines_out/nlines_in, nlines_in);
+  
+  
+  cleanup:
+    reader_close(&r);
+    fclose(fp_write);
+  
+  return ret;
+}
@@ -0,0 +1,589 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filesampler.h"
+#include "reader.h"
+#include "sampler.h"
+#include "timer.h"
+#include "utils.h"
+
+
+// -----------------------------------------------------------------------------
+// fields
+// -----------------------------------------------------------------------------
+
+static int grow(void **p, uint64_t *size, const uint64_t need, const size_t eltsize)
+{
+  uint64_t newsize;
+  void *tmp;
+  
+  if (need <= *size)
+    return 0;
+  
+  newsize = (*size > 0) ? 2*(*size) : 1024;
+  while (newsize < need)
+    newsize *= 2;
+  
+  tmp = realloc(*p, newsize * eltsize);
+  if (tmp == NULL)
+    return MALLOC_FAIL;
+  
+  *p = tmp;
+  *size = newsize;
+  return 0;
+}
+
+
+
+// Split a line on sep into at most maxf fields, which are appended to the
+// text unquoted and NUL terminated.  Fields in double quotes may hold sep, and
+// "" in them is a quote.  Returns the number of fields, or maxf+1 if there
+// are more.
+static int split_fields(fs_table_t *t, uint64_t *textsize, const char *line, size_t len, const char sep, fs_field_t *f, const int maxf)
+{
+  const char *s = line;
+  const char *end;
+  char *out;
+  int nf = 0;
+  
+  if (len > 0 && line[len-1] == '\n')
+    len--;
+  if (len > 0 && line[len-1] == '\r')
+    len--;
+  
+  end = line + len;
+  
+  // unquoting only shortens the fields, so this is enough for the line and
+  // one NUL per field, padding included
+  if (grow((void**) &t->text, textsize, t->textlen + len + 1 + maxf, 1))
+    return MALLOC_FAIL;
+  
+  out = t->text + t->textlen;
+  
+  while (true)
+  {
+    char *field = out;
+    
+    if (nf == maxf)
+      return maxf + 1;
+    
+    if (s < end && *s == '"')
+    {
+      s++;
+      while (s < end)
+      {
+        if (*s == '"')
+        {
+          if (s+1 < end && s[1] == '"')
+            s++;
+          else
+          {
+            s++;
+            break;
+          }
+        }
+        
+        *out++ = *s++;
+      }
+    }
+    
+    while (s < end && *s != sep)
+      *out++ = *s++;
+    
+    f[nf].start = (uint64_t) (field - t->text);
+    f[nf].len = (uint64_t) (out - field);
+    *out++ = '\0';
+    nf++;
+    
+    if (s == end)
+      break;
+    
+    s++;
+  }
+  
+  t->textlen = (uint64_t) (out - t->text);
+  return nf;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// types
+// -----------------------------------------------------------------------------
+
+static inline void trim(const char **s, size_t *len)
+{
+  while (*len > 0 && (**s == ' ' || **s == '\t'))
+  {
+    (*s)++;
+    (*len)--;
+  }
+  
+  while (*len > 0 && ((*s)[*len-1] == ' ' || (*s)[*len-1] == '\t'))
+    (*len)--;
+}
+
+
+
+// Blank fields and NA are missing
+static inline bool is_na(const char *s, const size_t len)
+{
+  return (len == 0 || (len == 2 && s[0] == 'N' && s[1] == 'A'));
+}
+
+
+
+static inline bool parse_logical(const char *s, const size_t len, int32_t *x)
+{
+  static const char *true_str[] = {"T", "TRUE", "True", "true"};
+  static const char *false_str[] = {"F", "FALSE", "False", "false"};
+  
+  for (int i=0; i<4; i++)
+  {
+    if (len == strlen(true_str[i]) && memcmp(s, true_str[i], len) == 0)
+    {
+      *x = 1;
+      return true;
+    }
+    else if (len == strlen(false_str[i]) && memcmp(s, false_str[i], len) == 0)
+    {
+      *x = 0;
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+
+
+// Decimal integers in (-2^31, 2^31); -2^31 is NA in R
+static inline bool parse_int(const char *s, const size_t len, int32_t *x)
+{
+  size_t i = 0;
+  bool neg = false;
+  int64_t v = 0;
+  
+  if (len > 0 && (s[0] == '-' || s[0] == '+'))
+  {
+    neg = (s[0] == '-');
+    i++;
+  }
+  
+  if (i == len || len - i > 10)
+    return false;
+  
+  for (; i<len; i++)
+  {
+    if (s[i] < '0' || s[i] > '9')
+      return false;
+    
+    v = 10*v + (s[i] - '0');
+  }
+  
+  if (v > INT32_MAX)
+    return false;
+  
+  *x = (int32_t) (neg ? -v : v);
+  return true;
+}
+
+
+
+// s is NUL terminated (at or after s[len])
+static inline bool parse_double(const char *s, const size_t len, double *x)
+{
+  char *end;
+  
+  *x = strtod(s, &end);
+  return (end == s + len);
+}
+
+
+
+// The narrowest type of FS_COL_LOGICAL, FS_COL_INTEGER, FS_COL_DOUBLE and
+// FS_COL_STRING that holds both the column so far and the field.  A column of
+// missing values only is logical.  Logicals and numbers don't mix.
+static inline int widen(const int type, bool *logical, const char *s, size_t len)
+{
+  int32_t i;
+  double d;
+  
+  if (type == FS_COL_STRING)
+    return type;
+  
+  trim(&s, &len);
+  if (is_na(s, len))
+    return type;
+  
+  if (parse_logical(s, len, &i))
+  {
+    *logical = true;
+    return (type == FS_COL_LOGICAL) ? type : FS_COL_STRING;
+  }
+  else if (*logical)
+    return FS_COL_STRING;
+  else if (parse_int(s, len, &i))
+    return (type == FS_COL_LOGICAL) ? FS_COL_INTEGER : type;
+  else if (parse_double(s, len, &d))
+    return FS_COL_DOUBLE;
+  else
+    return FS_COL_STRING;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// sampler
+// -----------------------------------------------------------------------------
+
+static int table_init(fs_table_t *t, const int ncols, bool **logical)
+{
+  t->ncols = ncols;
+  t->types = malloc(ncols * sizeof(*t->types));
+  *logical = calloc(ncols, sizeof(**logical));
+  if ((ncols > 0 && t->types == NULL) || (ncols > 0 && *logical == NULL))
+    return MALLOC_FAIL;
+  
+  for (int j=0; j<ncols; j++)
+    t->types[j] = FS_COL_LOGICAL;
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Table Sampler
+ *
+ * @details
+ * This function samples the lines of a delimited (csv) file as
+ * fs_sample_prop() does, with the same draws of the RNG, but rather
+ * than writing them out it splits them into fields in the scanning
+ * loop and infers the type of each column over the sample.  The
+ * columns are then filled with fs_table_fill_int(),
+ * fs_table_fill_double() and fs_table_field(), so a caller can parse
+ * the sample straight into its own typed vectors without writing it
+ * out and reading it back.
+ *
+ * Each line is a record, so quoted fields can't hold newlines.  Fields
+ * may be quoted with double quotes, with "" for a quote inside them.
+ * Blank lines are skipped.  Lines with fewer fields than the first are
+ * padded with blank fields.
+ *
+ * A column is logical (T, F, TRUE, FALSE, True, False, true, false)
+ * if all of its values are, otherwise integer if they all fit in 32
+ * bits, otherwise double if they all parse as one, and otherwise
+ * string.  Blank fields and NA are missing values; in a string column
+ * a blank field is the empty string.
+ *
+ * @param verbose
+ * Input.  Indicates whether line counts should be printed.
+ * @param header
+ * Input.  Indicates whether or not there is a header line.  If so,
+ * its fields are the column names.
+ * @param nskip
+ * Input.  Number of lines to skip after the header.
+ * @param nmax
+ * Input.  Max number of lines to read.  If nmax==0 then there is no max.
+ * @param p
+ * Input.  Proportion of lines to (randomly) retain.  With p=1, the
+ * whole file is read and the RNG is not used.
+ * @param sep
+ * Input.  The field separator.
+ * @param input
+ * Input.  Absolute path to input file.
+ * @param table
+ * Output, passed by reference.  The sample.  On success, free it
+ * with fs_table_free().
+ * @param stats
+ * Output, passed by reference.  If not NULL, timings and I/O counters
+ * are added to it.  See fs_stats_init().
+ *
+ * @note
+ * Due to R's RNG, this call (as written) is very un-threadsafe.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_sample_table(const bool verbose, const bool header, uint32_t nskip, uint32_t nmax, const double p, const char sep, const char *input, fs_table_t *table, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  char *line;
+  size_t len;
+  bool *logical = NULL;
+  fs_field_t *row;
+  fs_field_t *first = NULL;
+  uint64_t textsize = 0;
+  uint64_t nfields = 0;
+  uint64_t nlines_in = 0, nlines_out = 0;
+  const bool checkmax = nmax ? true : false;
+  const bool userng = (p < 1.);
+  const double start = fs_timer_now();
+  const double write_start = stats ? stats->time_write : 0.;
+  
+  memset(table, 0, sizeof(*table));
+  table->ncols = -1;
+  
+  if (p < 0. || p > 1.)
+    return INVALID_PROB;
+  
+  ret = reader_open(&r, input);
+  if (ret)
+    return ret;
+  
+  if (userng)
+    STARTRNG;
+  
+  if (header && (ret = reader_line(&r, &line, &len)) > 0)
+  {
+    fs_field_t *names;
+    int nf;
+    
+    nlines_in++;
+    
+    // no line has more fields than it has bytes
+    names = malloc((len + 1) * sizeof(*names));
+    if (names == NULL)
+    {
+      ret = MALLOC_FAIL;
+      goto cleanup;
+    }
+    
+    nf = split_fields(table, &textsize, line, len, sep, names, (int) len + 1);
+    if (nf < 0)
+    {
+      free(names);
+      ret = nf;
+      goto cleanup;
+    }
+    
+    table->names = names;
+    ret = table_init(table, nf, &logical);
+    if (ret)
+      goto cleanup;
+  }
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  while ((ret = reader_line(&r, &line, &len)) > 0)
+  {
+    int nf;
+    
+    if ((nlines_in % INTERRUPT_CHECK_NUM == 0) && check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    nlines_in++;
+    
+    if (userng && RUNIF >= p)
+      continue;
+    else if (nskip)
+    {
+      nskip--;
+      continue;
+    }
+    
+    // blank lines count towards nmax, as with fs_sample_prop()
+    if (!(len == 0 || line[0] == '\n' || (len > 1 && line[0] == '\r' && line[1] == '\n')))
+    {
+      // without a header, the first line retained sets the number of columns
+      if (table->ncols < 0)
+      {
+        first = malloc((len + 1) * sizeof(*first));
+        if (first == NULL)
+        {
+          ret = MALLOC_FAIL;
+          goto cleanup;
+        }
+        
+        nf = split_fields(table, &textsize, line, len, sep, first, (int) len + 1);
+        if (nf < 0)
+        {
+          ret = nf;
+          goto cleanup;
+        }
+        
+        // the fields are split again below
+        table->textlen = 0;
+        
+        ret = table_init(table, nf, &logical);
+        if (ret)
+          goto cleanup;
+      }
+      
+      ret = grow((void**) &table->fields, &nfields, (table->nrows + 1) * table->ncols, sizeof(*table->fields));
+      if (ret)
+        goto cleanup;
+      
+      row = table->fields + table->nrows*table->ncols;
+      nf = split_fields(table, &textsize, line, len, sep, row, table->ncols);
+      if (nf < 0)
+      {
+        ret = nf;
+        goto cleanup;
+      }
+      else if (nf > table->ncols)
+      {
+        ret = TOO_MANY_FIELDS;
+        goto cleanup;
+      }
+      
+      // missing fields are blank; split_fields() left room for their NULs
+      for (int j=nf; j<table->ncols; j++)
+      {
+        row[j].start = table->textlen;
+        row[j].len = 0;
+        table->text[table->textlen++] = '\0';
+      }
+      
+      for (int j=0; j<table->ncols; j++)
+        table->types[j] = widen(table->types[j], logical + j, table->text + row[j].start, (size_t) row[j].len);
+      
+      table->nrows++;
+    }
+    
+    nlines_out++;
+    if (checkmax)
+    {
+      nmax--;
+      if (!nmax)
+        break;
+    }
+  }
+  
+  if (ret < 0)
+    goto cleanup;
+  
+  ret = 0;
+  if (table->ncols < 0)
+    table->ncols = 0;
+  
+  if (header && nlines_in > 0)
+    nlines_out++;
+  
+  finalize_stats_n(r.bytes, r.nreads, reader_backend_name(&r), NULL, 0, start, write_start, nlines_in, nlines_out, stats);
+  
+  if (verbose)
+  {
+    if (checkmax && !nmax)
+      PRINTFUN("Read nmax=%llu lines of unknown length file.\n", nlines_out);
+    else
+      PRINTFUN("Read %llu lines (%.5f%%) of %llu line file.\n", nlines_out, (double) nlines_out/nlines_in, nlines_in);
+  }
+  
+  
+  cleanup:
+    if (userng)
+      ENDRNG;
+    
+    reader_close(&r);
+    free(logical);
+    free(first);
+    if (ret)
+      fs_table_free(table);
+  
+  return ret;
+}
+
+
+
+// Column col of the table as 32-bit integers, with na for missing values.
+// Logical columns are 0 (false) and 1 (true).
+void fs_table_fill_int(const fs_table_t *table, const int col, int32_t *x, const int32_t na)
+{
+  const bool logical = (table->types[col] == FS_COL_LOGICAL);
+  
+  for (uint64_t i=0; i<table->nrows; i++)
+  {
+    const fs_field_t *f = table->fields + i*table->ncols + col;
+    const char *s = table->text + f->start;
+    size_t len = (size_t) f->len;
+    
+    trim(&s, &len);
+    if (is_na(s, len) || !(logical ? parse_logical(s, len, x + i) : parse_int(s, len, x + i)))
+      x[i] = na;
+  }
+}
+
+
+
+// Column col of the table as doubles, with na for missing values
+void fs_table_fill_double(const fs_table_t *table, const int col, double *x, const double na)
+{
+  for (uint64_t i=0; i<table->nrows; i++)
+  {
+    const fs_field_t *f = table->fields + i*table->ncols + col;
+    const char *s = table->text + f->start;
+    size_t len = (size_t) f->len;
+    
+    trim(&s, &len);
+    if (is_na(s, len) || !parse_double(s, len, x + i))
+      x[i] = na;
+  }
+}
+
+
+
+// Field col of row i of the table (NUL terminated), or false if it is NA.
+// This is for string columns: blank fields are empty strings, not missing.
+bool fs_table_field(const fs_table_t *table, const uint64_t row, const int col, const char **s, size_t *len)
+{
+  const fs_field_t *f = table->fields + row*table->ncols + col;
+  
+  *s = table->text + f->start;
+  *len = (size_t) f->len;
+  
+  return !(*len == 2 && (*s)[0] == 'N' && (*s)[1] == 'A');
+}
+
+
+
+void fs_table_free(fs_table_t *table)
+{
+  free(table->text);
+  free(table->fields);
+  free(table->names);
+  free(table->types);
+  table->text = NULL;
+  table->fields = NULL;
+  table->names = NULL;
+  table->types = NULL;
+  table->ncols = 0;
+  table->nrows = 0;
+}
@@ -0,0 +1,71 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "filesampler.h"
+#include "threads.h"
+
+
+static int nthreads_max = 0;
+
+/**
+ * @file
+ * @brief
+ * Set the Number of Threads
+ *
+ * @details
+ * Sets the number of threads used by the parallel passes of the exact
+ * sampler.  With more than one, the proportional sampler also writes its
+ * text output from a second thread.  With 0 (the default), OpenMP decides (usually one per core,
+ * or OMP_NUM_THREADS).  With 1, the serial code paths are used.  If the
+ * package was built without OpenMP, everything runs serially.
+ *
+ * @param nthreads
+ * Input.  The number of threads, or 0 for the OpenMP default.
+ *
+ * @return
+ * The previous setting.
+ */
+int fs_set_nthreads(const int nthreads)
+{
+  const int old = nthreads_max;
+  nthreads_max = (nthreads > 0) ? nthreads : 0;
+  return old;
+}
+
+
+
+int fs_get_nthreads()
+{
+#ifdef _OPENMP
+  if (nthreads_max > 0)
+    return nthreads_max;
+  else
+    return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
@@ -0,0 +1,37 @@
+// This file is free and unencumbered software released into the public domain.
+// You may modify it for any purpose with or without attribution.
+// See the Unlicense specification for full details http://unlicense.org/
+
+#ifndef FILESAMPLER_THREADS_H_
+#define FILESAMPLER_THREADS_H_
+
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// threads.c; the number of threads to use, see fs_set_nthreads()
+int fs_get_nthreads();
+
+// index of the calling thread in a parallel region
+static inline int fs_thread_num()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+// number of threads of the enclosing parallel region
+static inline int fs_team_size()
+{
+#ifdef _OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+
+#endif
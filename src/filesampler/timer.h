@@ -0,0 +1,24 @@
+// This file is free and unencumbered software released into the public domain.
+// You may modify it for any purpose with or without attribution.
+// See the Unlicense specification for full details http://unlicense.org/
+
+#ifndef FILESAMPLER_TIMER_H_
+#define FILESAMPLER_TIMER_H_
+
+
+#include <time.h>
+
+// wall clock time in seconds; only differences are meaningful
+static inline double fs_timer_now()
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+#endif
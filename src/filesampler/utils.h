@@ -29,6 +29,13 @@
 // generate a single random uniform number
 #define RUNIF unif_rand()
 
+// generate a single binomial(n, p) number (as a double)
+#define RBINOM(n, p) rbinom(n, p)
+
+// generate a single hypergeometric number (as a double): the white balls among
+// n drawn without replacement from nw white and nb black
+#define RHYPER(nw, nb, n) rhyper(nw, nb, n)
+
 
 
 // ----------------------------------------------------------------------------
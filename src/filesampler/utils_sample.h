@@ -18,6 +18,34 @@
 
 #define RUNIF ((double) rand() / (RAND_MAX+1))
 
+// slow, but fine for small n
+static inline double RBINOM(double n, double p)
+{
+  double x = 0.;
+  for (double i=0.; i<n; i++)
+    x += (RUNIF < p);
+  
+  return x;
+}
+
+// also slow for large n
+static inline double RHYPER(double nw, double nb, double n)
+{
+  double x = 0.;
+  for (double i=0.; i<n; i++)
+  {
+    if (RUNIF*(nw + nb) < nw)
+    {
+      x++;
+      nw--;
+    }
+    else
+      nb--;
+  }
+  
+  return x;
+}
+
 
 
 // ----------------------------------------------------------------------------
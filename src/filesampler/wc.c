@@ -25,258 +25,546 @@
 */
 
 
-#include <ctype.h> // isspace()
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include "check_avx.h"
 #include "filesampler.h"
+#include "linefeed.h"
+#include "reader.h"
 #include "safeomp.h"
+#include "sampler.h"
+#include "threads.h"
+#include "timer.h"
 #include "utils.h"
 
 
+
+// -----------------------------------------------------------------------------
+// line lengths
+// -----------------------------------------------------------------------------
+
+static inline void linelen_add(fs_linelen_t *ll, const uint64_t len)
+{
+  int b = 0;
+  
+#if defined(__GNUC__)
+  if (len)
+    b = 64 - __builtin_clzll(len);
+#else
+  for (uint64_t l=len; l; l>>=1)
+    b++;
+#endif
+  
+  ll->counts[b]++;
+  ll->nlines++;
+  if (len > ll->max)
+    ll->max = len;
+  if (len < ll->min)
+    ll->min = len;
+}
+
+
+
 #ifdef __AVX2__
-  // we have AVX2 support
-  #ifndef _MSC_VER
-    /* Non-Microsoft C/C++-compatible compiler */
-    #include <x86intrin.h> // on some recent GCC, this will declare posix_memalign
-  #else
-    /* Microsoft C/C++-compatible compiler */
-    #include <intrin.h>
-  #endif
-
-  // http://lemire.me/blog/2017/02/14/how-fast-can-you-count-lines/
-  static inline size_t linefeedcount_avx2(char *const restrict buffer, const size_t size)
-  {
-    size_t answer = 0;
-    __m256i cnt = _mm256_setzero_si256();
-    __m256i newline = _mm256_set1_epi8('\n');
+  // Walk the set bits of the newline masks rather than the bytes, so the
+  // cost is per line and the scan runs at about line counting speed
+  static inline void linelen_avx2(const char *const restrict buffer, const size_t size, const uint64_t offset, uint64_t *restrict linestart, fs_linelen_t *restrict ll)
+  {
+    const __m256i newline = _mm256_set1_epi8('\n');
     size_t i = 0;
-    uint8_t tmpbuffer[sizeof(__m256i)];
     
-    while (i + 32 <= size)
+    for (; i + 32 <= size; i += 32)
     {
-      size_t remaining = size - i;
-      size_t howmanytimes =  remaining / 32;
-      
-      if (howmanytimes > 256)
-        howmanytimes = 256;
+      const __m256i data = _mm256_lddqu_si256((const __m256i*) (buffer + i));
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(newline, data));
       
-      const __m256i *buf = (const __m256i*) (buffer + i);
-      size_t j = 0;
-      
-      for (; j + 3 <  howmanytimes; j+= 4)
+      while (mask)
       {
-        __m256i newdata1 = _mm256_lddqu_si256(buf + j);
-        __m256i newdata2 = _mm256_lddqu_si256(buf + j + 1);
-        __m256i newdata3 = _mm256_lddqu_si256(buf + j + 2);
-        __m256i newdata4 = _mm256_lddqu_si256(buf + j + 3);
-        __m256i cmp1 = _mm256_cmpeq_epi8(newline, newdata1);
-        __m256i cmp2 = _mm256_cmpeq_epi8(newline, newdata2);
-        __m256i cmp3 = _mm256_cmpeq_epi8(newline, newdata3);
-        __m256i cmp4 = _mm256_cmpeq_epi8(newline, newdata4);
-        __m256i cnt1 = _mm256_add_epi8(cmp1, cmp2);
-        __m256i cnt2 = _mm256_add_epi8(cmp3, cmp4);
-        cnt = _mm256_add_epi8(cnt, cnt1);
-        cnt = _mm256_add_epi8(cnt, cnt2);
+        const uint64_t end = offset + i + __builtin_ctz(mask) + 1;
+        linelen_add(ll, end - *linestart);
+        *linestart = end;
+        mask &= mask - 1;
       }
-      
-      for (; j <  howmanytimes; j++)
-      {
-        __m256i newdata = _mm256_lddqu_si256(buf + j);
-        __m256i cmp = _mm256_cmpeq_epi8(newline, newdata);
-        cnt = _mm256_add_epi8(cnt, cmp);
-      }
-      
-      i += howmanytimes * 32;
-      cnt = _mm256_subs_epi8(_mm256_setzero_si256(), cnt);
-      _mm256_storeu_si256((__m256i *) tmpbuffer, cnt);
-      
-      for (unsigned int k = 0; k < sizeof(__m256i); ++k)
-        answer += tmpbuffer[k];
-      
-      cnt = _mm256_setzero_si256();
     }
     
     for (; i < size; i++)
     {
       if (buffer[i] == '\n')
-        answer++;
+      {
+        const uint64_t end = offset + i + 1;
+        linelen_add(ll, end - *linestart);
+        *linestart = end;
+      }
     }
-    
-    return answer;
   }
 #endif
 
 
 
-static inline size_t linefeedcount_fallback(char *const restrict buffer, const size_t size)
+static inline void linelen_fallback(const char *const restrict buffer, const size_t size, const uint64_t offset, uint64_t *restrict linestart, fs_linelen_t *restrict ll)
 {
-  uint64_t nl = 0;
-  char *ptr = buffer;
-  char *last = buffer + size;
+  const char *ptr = buffer;
+  const char *last = buffer + size;
   
   while ((ptr = memchr(ptr, '\n', last - ptr)))
   {
+    const uint64_t end = offset + (ptr - buffer) + 1;
+    linelen_add(ll, end - *linestart);
+    *linestart = end;
     ptr++;
-    nl++;
   }
-  
-  return nl;
 }
 
 
 
-static inline size_t linefeedcount(char *const restrict buffer, const size_t size)
+static inline void linelen(const char *const restrict buffer, const size_t size, const uint64_t offset, uint64_t *restrict linestart, fs_linelen_t *restrict ll)
 {
 #ifdef __AVX2__
   if (has_avx2())
-    return linefeedcount_avx2(buffer, size);
+    linelen_avx2(buffer, size, offset, linestart, ll);
   else
 #endif
-    return linefeedcount_fallback(buffer, size);
+    linelen_fallback(buffer, size, offset, linestart, ll);
 }
 
 
 
 // -----------------------------------------------------------------------------
-// wrappers
+// counting kernels
 // -----------------------------------------------------------------------------
 
-static inline int wc_charsonly(FILE *restrict fp, char *restrict buf, uint64_t *restrict nchars)
+#if defined(__GNUC__)
+  #define WC_INLINE static inline __attribute__((always_inline))
+#else
+  #define WC_INLINE static inline
+#endif
+
+typedef struct wc_counts_t
 {
-  size_t readlen = BUFLEN;
-  uint64_t nc = 0;
-  
-  while (readlen == BUFLEN)
+  uint64_t nchars;
+  uint64_t nwords;
+  uint64_t nlines;
+} wc_counts_t;
+
+// The word count is the number of whitespace bytes, as isspace() has them in
+// the C locale
+static inline bool iswordsep(const char c)
+{
+  return (c == ' ') || (c >= '\t' && c <= '\r');
+}
+
+
+
+#ifdef __AVX2__
+  // Words, and lines with them; the byte counters are added up as by
+  // linefeedcount_avx2()
+  WC_INLINE void wc_count_avx2(const char *const restrict buffer, const size_t size, const bool words, const bool lines, wc_counts_t *restrict c)
   {
-    if (check_interrupt())
-      return USER_INTERRUPT;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8('\r' - '\t');
+    uint64_t nw = 0, nl = 0;
+    size_t i = 0;
+    
+    while (i + 32 <= size)
+    {
+      __m256i cnt_w = zero;
+      __m256i cnt_l = zero;
+      size_t n = (size - i) / 32;
+      if (n > LINEFEED_WINDOW)
+        n = LINEFEED_WINDOW;
+      
+      for (size_t j=0; j<n; j++, i+=32)
+      {
+        const __m256i data = _mm256_lddqu_si256((const __m256i*) (buffer + i));
+        
+        if (lines)
+          cnt_l = _mm256_sub_epi8(cnt_l, _mm256_cmpeq_epi8(data, newline));
+        
+        if (words)
+        {
+          // '\t' to '\r' by one unsigned comparison
+          const __m256i d = _mm256_sub_epi8(data, tab);
+          const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(d, four), d);
+          cnt_w = _mm256_sub_epi8(cnt_w, _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(data, space)));
+        }
+      }
+      
+      if (lines)
+        nl += linefeed_hsum_avx2(cnt_l);
+      if (words)
+        nw += linefeed_hsum_avx2(cnt_w);
+    }
+    
+    for (; i<size; i++)
+    {
+      if (lines && buffer[i] == '\n')
+        nl++;
+      if (words && iswordsep(buffer[i]))
+        nw++;
+    }
     
-    readlen = fread(buf, sizeof(char), BUFLEN, fp);
-    nc += readlen;
+    c->nwords += nw;
+    c->nlines += nl;
   }
+#endif
+
+
+
+WC_INLINE void wc_count_scalar(const char *const restrict buffer, const size_t size, const bool words, const bool lines, wc_counts_t *restrict c)
+{
+  uint64_t nw = 0, nl = 0;
   
-  *nchars = nc;
+  for (size_t i=0; i<size; i++)
+  {
+    nw += iswordsep(buffer[i]);
+    if (lines)
+      nl += (buffer[i] == '\n');
+  }
   
-  return 0;
+  c->nwords += nw;
+  c->nlines += nl;
 }
 
 
 
-static inline int wc_linesonly(FILE *restrict fp, char *restrict buf, uint64_t *restrict nlines)
+// The one counting kernel.  It is only ever called with constant flags, so
+// each instantiation below is compiled to a loop that does only its own
+// counting.
+WC_INLINE void wc_count(const char *const restrict buffer, const size_t size, const bool chars, const bool words, const bool lines, wc_counts_t *restrict c)
 {
-  size_t readlen = BUFLEN;
-  uint64_t nl = 0;
+  if (chars)
+    c->nchars += size;
   
-  while (readlen == BUFLEN)
+  if (!words && !lines)
+    return;
+  
+  // lines alone are counted by the newline kernel that everything else uses
+  if (!words)
   {
-    if (check_interrupt())
-      return USER_INTERRUPT;
-    
-    readlen = fread(buf, sizeof(*buf), BUFLEN, fp);
-    nl += linefeedcount(buf, readlen);
+    c->nlines += linefeedcount((char*) buffer, size);
+    return;
   }
   
-  *nlines = nl;
-  
-  return 0;
+#ifdef __AVX2__
+  if (has_avx2())
+    wc_count_avx2(buffer, size, words, lines, c);
+  else
+#endif
+    wc_count_scalar(buffer, size, words, lines, c);
+}
+
+
+
+#define WC_KERNEL(name, chars, words, lines) \
+  static void name(const char *const restrict buffer, const size_t size, wc_counts_t *restrict c) \
+  { \
+    wc_count(buffer, size, chars, words, lines, c); \
+  }
+
+WC_KERNEL(wc_c,   true,  false, false)
+WC_KERNEL(wc_w,   false, true,  false)
+WC_KERNEL(wc_l,   false, false, true)
+WC_KERNEL(wc_cw,  true,  true,  false)
+WC_KERNEL(wc_cl,  true,  false, true)
+WC_KERNEL(wc_wl,  false, true,  true)
+WC_KERNEL(wc_cwl, true,  true,  true)
+
+typedef void (*wc_kernel_t)(const char *const restrict, const size_t, wc_counts_t *restrict);
+
+// The kernel for a combination of counts; asking for none gets all three
+static inline wc_kernel_t wc_kernel(const bool chars, const bool words, const bool lines)
+{
+  static const wc_kernel_t kernels[8] = {wc_cwl, wc_l, wc_w, wc_wl, wc_c, wc_cl, wc_cw, wc_cwl};
+  return kernels[(chars << 2) | (words << 1) | lines];
 }
 
 
 
-static inline int wc_nowords(FILE *restrict fp, char *restrict buf, uint64_t *restrict nchars, uint64_t *restrict nlines)
+static inline const char* wc_kernel_name(const bool words, const bool lines)
 {
-  size_t readlen = BUFLEN;
-  uint64_t nc = 0;
-  uint64_t nl = 0;
+  if (!words && !lines)
+    return NULL;
+  else if (!words)
+    return linefeedcount_kernel();
+#ifdef __AVX2__
+  else if (has_avx2())
+    return "avx2";
+#endif
+  else
+    return "scalar";
+}
+
+
+
+// Runs until reader_next() reports the end of the file (0) or an error
+// (negative), and returns whichever of the two it was
+static int wc_scan(reader_t *restrict r, const wc_kernel_t kernel, wc_counts_t *restrict c)
+{
+  int ret;
+  char *buf;
+  size_t readlen;
   
-  while (readlen == BUFLEN)
+  while ((ret = reader_next(r, &buf, &readlen)) > 0)
   {
     if (check_interrupt())
       return USER_INTERRUPT;
     
-    readlen = fread(buf, sizeof(*buf), BUFLEN, fp);
-    nl += linefeedcount(buf, readlen);
-    nc += readlen;
+    kernel(buf, readlen, c);
   }
   
-  *nchars = nc;
-  *nlines = nl;
-  
-  return 0;
+  return ret;
 }
 
 
 
-static inline int wc_nolines(FILE *restrict fp, char *restrict buf, uint64_t *restrict nchars, uint64_t *restrict nwords)
+// Blocks counted per round of the parallel count; interrupts are checked
+// between rounds, from the main thread
+#define PAR_ROUND_BLOCKS 64
+
+// Count the newlines of each block concurrently, each thread reading its
+// blocks with pread(), then take the prefix sums.  Returns 1 without doing
+// anything if the input is not a regular file.
+static int wc_checkpoints_par(const char *file, const int nthreads, uint64_t *nlines, uint64_t **checkpoints, uint64_t *ncheckpoints, fs_stats_t *stats)
 {
-  size_t readlen = BUFLEN;
-  uint64_t nc = 0;
-  uint64_t nw = 0;
+  int ret = 0;
+  int fd;
+  struct stat sb;
+  char *bufs;
+  uint64_t *cp;
+  uint64_t filesize, nblocks;
+  uint64_t nl = 0;
+  uint64_t nreads = 0;
+  const double start = fs_timer_now();
+  
+  fd = open(file, O_RDONLY);
+  if (fd < 0)
+    return READ_FAIL;
+  
+  if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(fd);
+    return 1;
+  }
   
-  while (readlen == BUFLEN)
+  filesize = (uint64_t) sb.st_size;
+  nblocks = (filesize + FS_BLOCKLEN - 1) / FS_BLOCKLEN;
+  cache_start(fd);
+  
+  cp = malloc((nblocks > 0 ? nblocks : 1) * sizeof(*cp));
+  bufs = malloc((size_t) nthreads * FS_BLOCKLEN);
+  if (cp == NULL || bufs == NULL)
   {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  for (uint64_t b0=0; b0<nblocks; b0+=PAR_ROUND_BLOCKS)
+  {
+    const uint64_t b1 = (b0 + PAR_ROUND_BLOCKS < nblocks) ? b0 + PAR_ROUND_BLOCKS : nblocks;
+    int readfail = 0;
+    
     if (check_interrupt())
-      return USER_INTERRUPT;
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
     
-    readlen = fread(buf, sizeof(char), BUFLEN, fp);
+    // the next round is read in while this one is counted
+    if (b1 < nblocks)
+      cache_ahead(fd, b1*FS_BLOCKLEN, PAR_ROUND_BLOCKS*FS_BLOCKLEN);
     
-    SAFE_FOR_SIMD
-    for (size_t i=0; i<readlen; i++)
+    // cp[b] holds the count of block b until the prefix sum below
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(nthreads) schedule(static,1) reduction(+:nreads) reduction(|:readfail)
+    #endif
+    for (uint64_t b=b0; b<b1; b++)
     {
-      if (isspace(buf[i]))
-        nw++;
+      char *buf = bufs + (size_t) fs_thread_num() * FS_BLOCKLEN;
+      const uint64_t offset = b*FS_BLOCKLEN;
+      const size_t len = (filesize - offset > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (filesize - offset);
       
-      nc++;
+      if (pread_full(fd, buf, len, offset, &nreads))
+        readfail = 1;
+      else
+        cp[b] = linefeedcount(buf, len);
+    }
+    
+    if (readfail)
+    {
+      ret = READ_FAIL;
+      goto cleanup;
+    }
+    
+    cache_done(fd, b0*FS_BLOCKLEN, (b1 - b0)*FS_BLOCKLEN);
+    
+    for (uint64_t b=b0; b<b1; b++)
+    {
+      const uint64_t count = cp[b];
+      cp[b] = nl;
+      nl += count;
     }
   }
   
-  *nchars = nc;
-  *nwords = nw;
-
-  return 0;
+  if (stats)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += filesize;
+    stats->nreads += nreads;
+    stats->lines_read += nl;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = "pread";
+  }
+  
+  *nlines = nl;
+  *checkpoints = cp;
+  *ncheckpoints = nblocks;
+  cp = NULL;
+  
+  
+  cleanup:
+    close(fd);
+    free(bufs);
+    free(cp);
+  
+  return ret;
 }
 
 
 
-static inline bool isnewline(const char c)
-{
-  return (c=='\n') ? true : false;
-}
-
-static inline int wc_full(FILE *restrict fp, char *restrict buf, uint64_t *restrict nchars, uint64_t *restrict nwords, uint64_t *restrict nlines)
+/**
+ * @file
+ * @brief
+ * Line Count with Checkpoints
+ *
+ * @details
+ * Counts the lines of a file like fs_wc(), and also records a coarse
+ * index of it: the number of newlines before the start of every
+ * FS_BLOCKLEN sized block.  So the line that starts after the i'th
+ * newline is found by seeking to the last block with fewer than i
+ * newlines before it and scanning forward at most one block.  Since
+ * the blocks are the ones the counting loop reads anyway, this costs
+ * nothing extra, and the table is small (8 bytes per FS_BLOCKLEN bytes
+ * of file).
+ * 
+ * If more than one thread is available (see fs_set_nthreads()) and the
+ * input is a regular file, the blocks are read and counted
+ * concurrently.
+ *
+ * @param file
+ * Input.  Absolute path to the file.
+ * @param nlines
+ * Output, passed by reference.  The number of lines of the file.
+ * @param checkpoints
+ * Output, passed by reference.  On successful return, a newly
+ * allocated array; checkpoints[i] is the number of newlines before
+ * byte i*FS_BLOCKLEN of the file.  The caller should free() it.  Set
+ * to NULL if the blocks could not be indexed (e.g., the input is a
+ * pipe).
+ * @param ncheckpoints
+ * Output, passed by reference.  Length of checkpoints.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_wc_checkpoints(const char *file, uint64_t *nlines, uint64_t **checkpoints, uint64_t *ncheckpoints, fs_stats_t *stats)
 {
-  uint64_t nc = 0;
-  uint64_t nw = 0;
+  int ret;
+  reader_t r;
+  char *buf;
+  size_t readlen;
   uint64_t nl = 0;
-  size_t readlen = BUFLEN;
-
-  while (readlen == BUFLEN)
+  uint64_t n = 0;
+  uint64_t len = 64;
+  uint64_t *cp;
+  const double start = fs_timer_now();
+  const int nthreads = fs_get_nthreads();
+  
+  *checkpoints = NULL;
+  *ncheckpoints = 0;
+  
+  if (nthreads > 1)
+  {
+    ret = wc_checkpoints_par(file, nthreads, nlines, checkpoints, ncheckpoints, stats);
+    if (ret <= 0)
+      return ret;
+  }
+  
+  cp = malloc(len * sizeof(*cp));
+  if (cp == NULL)
+    return MALLOC_FAIL;
+  
+  ret = reader_open(&r, file);
+  if (ret)
+  {
+    free(cp);
+    return ret;
+  }
+  
+  while ((ret = reader_next(&r, &buf, &readlen)) > 0)
   {
     if (check_interrupt())
-      return USER_INTERRUPT;
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
     
-    readlen = fread(buf, sizeof(char), BUFLEN, fp);
-    nc += readlen;
+    if (cp && r.block_offset != n*FS_BLOCKLEN)
+    {
+      free(cp);
+      cp = NULL;
+    }
     
-    SAFE_FOR_SIMD
-    for (size_t i=0; i<readlen; i++)
+    if (cp)
     {
-      if (isnewline(buf[i]))
-      {
-        nw++;
-        nl++;
-      }
-      else
+      if (n == len)
       {
-        if (isspace(buf[i]))
-          nw++;
+        uint64_t *tmp;
+        len *= 2;
+        tmp = realloc(cp, len * sizeof(*cp));
+        if (tmp == NULL)
+        {
+          ret = MALLOC_FAIL;
+          break;
+        }
+        
+        cp = tmp;
       }
+      
+      cp[n++] = nl;
     }
+    
+    nl += linefeedcount(buf, readlen);
+  }
+  
+  if (stats && !ret)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += r.bytes;
+    stats->nreads += r.nreads;
+    stats->lines_read += nl;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = reader_backend_name(&r);
+  }
+  
+  reader_close(&r);
+  
+  if (ret)
+  {
+    free(cp);
+    return ret;
   }
   
-  *nchars = nc;
-  *nwords = nw;
   *nlines = nl;
+  *checkpoints = cp;
+  *ncheckpoints = cp ? n : 0;
   
   return 0;
 }
@@ -306,41 +594,581 @@ static inline int wc_full(FILE *restrict fp, char *restrict buf, uint64_t *restr
  * @param nlines
  * Output, passed by reference.  On successful return, the value
  * is set to the number of lines in the file.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
  *
  * @return
  * The return value indicates the status of the function.
  */
 int fs_wc(const char *file, const bool chars, uint64_t *nchars, 
-  const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines)
+  const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines,
+  fs_stats_t *stats)
 {
   int ret = 0;
-  FILE *fp;
+  reader_t r;
+  wc_counts_t c = {0, 0, 0};
+  const double start = fs_timer_now();
+  
+  ret = reader_open(&r, file);
+  if (ret)
+    return ret;
+  
+  ret = wc_scan(&r, wc_kernel(chars, words, lines), &c);
+  
+  if (!ret)
+  {
+    if (chars)
+      *nchars = c.nchars;
+    if (words)
+      *nwords = c.nwords;
+    if (lines)
+      *nlines = c.nlines;
+  }
+  
+  if (stats && !ret)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += r.bytes;
+    stats->nreads += r.nreads;
+    if (lines)
+      stats->lines_read += *nlines;
+    stats->kernel = wc_kernel_name(words, lines);
+    stats->backend = reader_backend_name(&r);
+  }
+  
+  reader_close(&r);
+  
+  return ret;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Line Length Histogram
+ *
+ * @details
+ * Scans the file like fs_wc() and records the length of every line in
+ * a histogram with logarithmic buckets, along with the shortest and
+ * longest lines.  Lengths are in bytes and include the newline, so the
+ * lengths add up to the size of the file.  A last line without a
+ * newline is counted too.
+ *
+ * @param file
+ * Input.  Absolute path to the file.
+ * @param ll
+ * Output, passed by reference.  The histogram; see fs_linelen_t.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_wc_linelen(const char *file, fs_linelen_t *ll, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
   char *buf;
+  size_t readlen;
+  uint64_t offset = 0;
+  uint64_t linestart = 0;
+  const double start = fs_timer_now();
   
-  fp = fopen(file, "r");
-  if (!fp)
-    return READ_FAIL;
+  memset(ll, 0, sizeof(*ll));
+  ll->min = UINT64_MAX;
   
-  buf = malloc(BUFLEN * sizeof(*buf));
-  if (buf == NULL)
+  ret = reader_open(&r, file);
+  if (ret)
+    return ret;
+  
+  while ((ret = reader_next(&r, &buf, &readlen)) > 0)
   {
-    fclose(fp);
-    return MALLOC_FAIL;
+    if (check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    linelen(buf, readlen, offset, &linestart, ll);
+    offset += readlen;
+  }
+  
+  if (!ret)
+  {
+    if (offset > linestart)
+      linelen_add(ll, offset - linestart);
+    
+    ll->nchars = offset;
+    if (ll->nlines == 0)
+      ll->min = 0;
+  }
+  
+  if (stats && !ret)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += r.bytes;
+    stats->nreads += r.nreads;
+    stats->lines_read += ll->nlines;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = reader_backend_name(&r);
+  }
+  
+  reader_close(&r);
+  
+  return ret;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// fields
+// -----------------------------------------------------------------------------
+
+static inline void fields_add(fs_fields_t *f, const uint64_t n)
+{
+  f->nlines++;
+  if (f->nlines == 1)
+    f->nfields = n;
+  else if (n != f->nfields)
+  {
+    if (f->nanomalies < FS_FIELDS_NANOMALIES)
+      f->anomalies[f->nanomalies] = f->nlines;
+    
+    f->nanomalies++;
+  }
+  
+  if (n > f->max)
+    f->max = n;
+  if (n < f->min)
+    f->min = n;
+}
+
+
+
+#ifdef __AVX2__
+  // Separators are counted a vector at a time from the compare mask, and
+  // like linelen_avx2() only the newlines take a step of their own
+  static inline void fields_avx2(const char *const restrict buffer, const size_t size, const char sep, uint64_t *restrict nsep, fs_fields_t *restrict f)
+  {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i delim = _mm256_set1_epi8(sep);
+    uint64_t cur = *nsep;
+    size_t i = 0;
+    
+    for (; i + 32 <= size; i += 32)
+    {
+      const __m256i data = _mm256_lddqu_si256((const __m256i*) (buffer + i));
+      uint32_t nlmask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(newline, data));
+      uint32_t sepmask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(delim, data));
+      
+      while (nlmask)
+      {
+        // the bytes before the newline
+        const uint32_t before = (nlmask & -nlmask) - 1;
+        cur += __builtin_popcount(sepmask & before);
+        sepmask &= ~(before | (before + 1));
+        
+        fields_add(f, cur + 1);
+        cur = 0;
+        nlmask &= nlmask - 1;
+      }
+      
+      cur += __builtin_popcount(sepmask);
+    }
+    
+    for (; i < size; i++)
+    {
+      if (buffer[i] == '\n')
+      {
+        fields_add(f, cur + 1);
+        cur = 0;
+      }
+      else if (buffer[i] == sep)
+        cur++;
+    }
+    
+    *nsep = cur;
+  }
+#endif
+
+
+
+static inline void fields_fallback(const char *const restrict buffer, const size_t size, const char sep, uint64_t *restrict nsep, fs_fields_t *restrict f)
+{
+  uint64_t cur = *nsep;
+  
+  for (size_t i=0; i<size; i++)
+  {
+    if (buffer[i] == '\n')
+    {
+      fields_add(f, cur + 1);
+      cur = 0;
+    }
+    else if (buffer[i] == sep)
+      cur++;
+  }
+  
+  *nsep = cur;
+}
+
+
+
+static inline void fields(const char *const restrict buffer, const size_t size, const char sep, uint64_t *restrict nsep, fs_fields_t *restrict f)
+{
+#ifdef __AVX2__
+  if (has_avx2())
+    fields_avx2(buffer, size, sep, nsep, f);
+  else
+#endif
+    fields_fallback(buffer, size, sep, nsep, f);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Fields per Line
+ *
+ * @details
+ * Scans the file like fs_wc() and counts the fields of every line, split
+ * on sep, to check that the file is rectangular.  The first line is taken
+ * as the reference (the header, for a csv), and the lines with a different
+ * number of fields are reported.  Quoting is ignored, so a quoted separator
+ * makes an extra field.  An empty line has one field.  A last line without
+ * a newline is counted too.
+ *
+ * @param file
+ * Input.  Absolute path to the file.
+ * @param sep
+ * Input.  The field separator.  Should not be a newline.
+ * @param f
+ * Output, passed by reference.  The counts; see fs_fields_t.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_wc_fields(const char *file, const char sep, fs_fields_t *f, fs_stats_t *stats)
+{
+  int ret;
+  reader_t r;
+  char *buf;
+  size_t readlen;
+  uint64_t offset = 0;
+  uint64_t nsep = 0;
+  char last = '\n';
+  const double start = fs_timer_now();
+  
+  memset(f, 0, sizeof(*f));
+  f->min = UINT64_MAX;
+  
+  ret = reader_open(&r, file);
+  if (ret)
+    return ret;
+  
+  while ((ret = reader_next(&r, &buf, &readlen)) > 0)
+  {
+    if (check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      break;
+    }
+    
+    fields(buf, readlen, sep, &nsep, f);
+    offset += readlen;
+    if (readlen > 0)
+      last = buf[readlen - 1];
+  }
+  
+  if (!ret)
+  {
+    if (last != '\n')
+      fields_add(f, nsep + 1);
+    
+    f->nchars = offset;
+    if (f->nlines == 0)
+      f->min = 0;
+  }
+  
+  if (stats && !ret)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += r.bytes;
+    stats->nreads += r.nreads;
+    stats->lines_read += f->nlines;
+    stats->kernel = linefeedcount_kernel();
+    stats->backend = reader_backend_name(&r);
   }
   
-  if (!chars && !words && lines)
-    ret = wc_linesonly(fp, buf, nlines);
-  else if (chars && !words && lines)
-    ret = wc_nowords(fp, buf, nchars, nlines);
-  else if (chars && words && !lines)
-    ret = wc_nolines(fp, buf, nchars, nwords);
-  else if (chars && !words && !lines)
-    ret = wc_charsonly(fp, buf, nchars);
+  reader_close(&r);
+  
+  return ret;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// many files
+// -----------------------------------------------------------------------------
+
+// Files larger than this are counted in pieces of this size, so that a few
+// big files among many small ones don't leave the other threads idle
+#define WC_CHUNKLEN ((uint64_t) 64 * FS_BLOCKLEN)
+
+// Tasks handed out per thread per round; interrupts are checked between
+// rounds, from the main thread
+#define WC_ROUND_TASKS 16
+
+// A piece of a file.  Pipes and other non-regular files are one piece, read
+// to the end (len is UINT64_MAX).
+typedef struct wc_task_t
+{
+  int file;
+  uint64_t offset;
+  uint64_t len;
+  
+  wc_counts_t c;
+  uint64_t nreads;
+  int ret;
+} wc_task_t;
+
+
+
+static void wc_task(const char *file, char *buf, const wc_kernel_t kernel, wc_task_t *t)
+{
+  const int fd = open(file, O_RDONLY);
+  if (fd < 0)
+  {
+    t->ret = READ_FAIL;
+    return;
+  }
+  
+  if (t->len == UINT64_MAX)
+  {
+    ssize_t n;
+    while ((n = read(fd, buf, FS_BLOCKLEN)) != 0)
+    {
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0)
+      {
+        t->ret = READ_FAIL;
+        break;
+      }
+      
+      t->nreads++;
+      kernel(buf, (size_t) n, &t->c);
+    }
+  }
+  else
+  {
+    cache_start(fd);
+    
+    for (uint64_t pos=0; pos<t->len; pos+=FS_BLOCKLEN)
+    {
+      const size_t len = (t->len - pos > FS_BLOCKLEN) ? FS_BLOCKLEN : (size_t) (t->len - pos);
+      
+      if (pread_full(fd, buf, len, t->offset + pos, &t->nreads))
+      {
+        t->ret = READ_FAIL;
+        break;
+      }
+      
+      cache_done(fd, t->offset + pos, len);
+      kernel(buf, len, &t->c);
+    }
+  }
+  
+  close(fd);
+}
+
+
+
+// largest first, so the long tasks start early and the short ones fill in
+// around them
+static int comp_task(const void *a, const void *b)
+{
+  const wc_task_t *x = (const wc_task_t*) a;
+  const wc_task_t *y = (const wc_task_t*) b;
+  
+  if (x->len != y->len)
+    return (x->len < y->len) - (x->len > y->len);
+  else if (x->file != y->file)
+    return (x->file > y->file) - (x->file < y->file);
   else
-    ret = wc_full(fp, buf, nchars, nwords, nlines);
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Wordcounts of Many Files
+ *
+ * @details
+ * Counts the letters, words, and lines of each of a list of files, as
+ * fs_wc() would, in one parallel pass over all of them (see
+ * fs_set_nthreads()).  Files larger than WC_CHUNKLEN are split into
+ * pieces of that size, and the pieces of all of the files are handed
+ * out to the threads one at a time, largest first.  So the threads stay
+ * busy when the sizes are very uneven, such as with a few large files
+ * among many small ones, and no more than one file per thread is open
+ * at once.
+ *
+ * @param nfiles
+ * Input.  The number of files.
+ * @param files
+ * Input.  Absolute paths to the files.
+ * @param chars,words,lines
+ * Input.  Which counts to make.
+ * @param nchars,nwords,nlines
+ * Output.  Arrays of length nfiles, which on successful return hold the
+ * counts of each file.  Only those asked for are set; the others may
+ * be NULL.
+ * @param stats
+ * Output, passed by reference.  If not NULL, the counting time and
+ * read counters are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int fs_wc_many(const int nfiles, const char **files, const bool chars, uint64_t *nchars, const bool words, uint64_t *nwords, const bool lines, uint64_t *nlines, fs_stats_t *stats)
+{
+  int ret = 0;
+  wc_task_t *tasks;
+  char *bufs;
+  uint64_t ntasks = 0;
+  uint64_t len = 0;
+  uint64_t nreads = 0, bytes = 0, nl = 0;
+  const wc_kernel_t kernel = wc_kernel(true, words, lines);
+  const double start = fs_timer_now();
+  const int nthreads = fs_get_nthreads();
+  const uint64_t round = (uint64_t) nthreads * WC_ROUND_TASKS;
+  
+  // the pieces
+  for (int f=0; f<nfiles; f++)
+  {
+    struct stat sb;
+    if (stat(files[f], &sb) != 0)
+      return READ_FAIL;
+    
+    if (S_ISREG(sb.st_mode))
+      len += ((uint64_t) sb.st_size + WC_CHUNKLEN - 1) / WC_CHUNKLEN;
+    else
+      len++;
+  }
+  
+  tasks = malloc((len > 0 ? len : 1) * sizeof(*tasks));
+  bufs = malloc((size_t) nthreads * FS_BLOCKLEN);
+  if (tasks == NULL || bufs == NULL)
+  {
+    ret = MALLOC_FAIL;
+    goto cleanup;
+  }
+  
+  for (int f=0; f<nfiles; f++)
+  {
+    struct stat sb;
+    uint64_t size;
+    
+    if (stat(files[f], &sb) != 0)
+    {
+      ret = READ_FAIL;
+      goto cleanup;
+    }
+    
+    size = S_ISREG(sb.st_mode) ? (uint64_t) sb.st_size : UINT64_MAX;
+    for (uint64_t offset=0; offset<size && ntasks<len; offset+=WC_CHUNKLEN)
+    {
+      wc_task_t *t = tasks + ntasks++;
+      memset(t, 0, sizeof(*t));
+      t->file = f;
+      t->offset = offset;
+      t->len = (size == UINT64_MAX) ? UINT64_MAX : ((size - offset > WC_CHUNKLEN) ? WC_CHUNKLEN : size - offset);
+      
+      if (size == UINT64_MAX)
+        break;
+    }
+  }
+  
+  qsort(tasks, ntasks, sizeof(*tasks), comp_task);
+  
+  for (uint64_t t0=0; t0<ntasks; t0+=round)
+  {
+    const uint64_t t1 = (t0 + round < ntasks) ? t0 + round : ntasks;
+    
+    if (check_interrupt())
+    {
+      ret = USER_INTERRUPT;
+      goto cleanup;
+    }
+    
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(nthreads) schedule(dynamic,1)
+    #endif
+    for (uint64_t t=t0; t<t1; t++)
+    {
+      char *buf = bufs + (size_t) fs_thread_num() * FS_BLOCKLEN;
+      wc_task(files[tasks[t].file], buf, kernel, tasks + t);
+    }
+    
+    for (uint64_t t=t0; t<t1; t++)
+    {
+      if (tasks[t].ret)
+      {
+        ret = tasks[t].ret;
+        goto cleanup;
+      }
+    }
+  }
+  
+  for (int f=0; f<nfiles; f++)
+  {
+    if (chars)
+      nchars[f] = 0;
+    if (words)
+      nwords[f] = 0;
+    if (lines)
+      nlines[f] = 0;
+  }
+  
+  for (uint64_t t=0; t<ntasks; t++)
+  {
+    const int f = tasks[t].file;
+    if (chars)
+      nchars[f] += tasks[t].c.nchars;
+    if (words)
+      nwords[f] += tasks[t].c.nwords;
+    if (lines)
+      nlines[f] += tasks[t].c.nlines;
+    
+    nreads += tasks[t].nreads;
+    bytes += tasks[t].c.nchars;
+    nl += tasks[t].c.nlines;
+  }
+  
+  if (stats)
+  {
+    stats->time_count += fs_timer_now() - start;
+    stats->bytes_read += bytes;
+    stats->nreads += nreads;
+    if (lines)
+      stats->lines_read += nl;
+    stats->kernel = wc_kernel_name(words, lines);
+    stats->backend = "pread";
+  }
+  
   
-  fclose(fp);
-  free(buf);
+  cleanup:
+    free(tasks);
+    free(bufs);
   
   return ret;
 }
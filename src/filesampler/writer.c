@@ -0,0 +1,718 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+  #include <sys/sendfile.h>
+  #include <sys/syscall.h>
+#endif
+
+#include "filesampler.h"
+#include "sampler.h"
+#include "timer.h"
+#include "writer.h"
+
+
+static const char *method_names[] = {"copy_file_range", "splice", "sendfile", "buffered"};
+
+
+
+static inline bool copy_unsupported(const int err)
+{
+  return (err == ENOSYS || err == EXDEV || err == EINVAL || err == EBADF || err == EOPNOTSUPP || err == ETXTBSY || err == ESPIPE);
+}
+
+
+
+// One copy request with the current method.  Returns the number of bytes
+// copied, 0 if the method isn't supported here, or -1 on error.
+static int64_t copy_once(const int fd_in, const int method, const int fd_out, const uint64_t offset, const size_t len)
+{
+  ssize_t n = -1;
+  
+  while (1)
+  {
+#if defined(__linux__)
+    int64_t off_in = (int64_t) offset;
+    off_t off_sf = (off_t) offset;
+    
+    switch (method)
+    {
+#if defined(SYS_copy_file_range)
+      case WRITER_COPY_RANGE:
+        n = syscall(SYS_copy_file_range, fd_in, &off_in, fd_out, NULL, len, 0);
+        break;
+#endif
+#if defined(SYS_splice)
+      case WRITER_SPLICE:
+        n = syscall(SYS_splice, fd_in, &off_in, fd_out, NULL, len, 0);
+        break;
+#endif
+      case WRITER_SENDFILE:
+        n = sendfile(fd_out, fd_in, &off_sf, len);
+        break;
+      default:
+        errno = ENOSYS;
+    }
+#else
+    errno = ENOSYS;
+#endif
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && copy_unsupported(errno))
+      return 0;
+    if (n <= 0)
+      return -1;
+    
+    return (int64_t) n;
+  }
+}
+
+
+
+// Copy len bytes of the input starting at offset to the output.  Methods the
+// system refuses are dropped for good, down to reading the bytes back into
+// the stage and writing them through the stdio buffer.
+static int copy_run(writer_t *w, uint64_t offset, uint64_t len, fs_stats_t *stats)
+{
+  const int fd_out = fileno(w->fp);
+  
+  if (w->method != WRITER_BUFFERED)
+  {
+    const double start = stats ? fs_timer_now() : 0.;
+    uint64_t copied = 0;
+    
+    if (fflush(w->fp) != 0)
+      return WRITE_FAIL;
+    
+    while (len > 0 && w->method != WRITER_BUFFERED)
+    {
+      int64_t n = copy_once(w->fd_in, w->method, fd_out, offset, (size_t) len);
+      if (n < 0)
+        return WRITE_FAIL;
+      else if (n == 0)
+      {
+        w->method++;
+        continue;
+      }
+      
+      w->ncopies++;
+      copied += (uint64_t) n;
+      offset += (uint64_t) n;
+      len -= (uint64_t) n;
+    }
+    
+    // keep the stream's idea of its position in step with the file's
+    fseek(w->fp, 0, SEEK_END);
+    w->copied += copied;
+    
+    if (stats)
+    {
+      stats->time_write += fs_timer_now() - start;
+      stats->bytes_written += copied;
+    }
+  }
+  
+  while (len > 0)
+  {
+    uint64_t nreads = 0;
+    size_t blocklen = (len > WRITER_STAGE) ? WRITER_STAGE : (size_t) len;
+    
+    if (pread_full(w->fd_in, w->stage, blocklen, offset, &nreads))
+      return READ_FAIL;
+    
+    write_buf(w->stage, blocklen, w->fp, stats);
+    offset += blocklen;
+    len -= blocklen;
+  }
+  
+  return 0;
+}
+
+
+
+// ------------------------------------------------------
+// asynchronous output
+// ------------------------------------------------------
+
+static int write_full(const int fd, const char *buf, size_t len, uint64_t *nrequests)
+{
+  while (len > 0)
+  {
+    ssize_t n = write(fd, buf, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return WRITE_FAIL;
+    
+    buf += n;
+    len -= (size_t) n;
+    (*nrequests)++;
+  }
+  
+  return 0;
+}
+
+
+
+// Spin briefly, then sleep, so that an idle side doesn't take a core
+static inline void async_wait(int *spins)
+{
+  if (++(*spins) < 64)
+    sched_yield();
+  else
+  {
+    const struct timespec ts = {0, 100000};
+    nanosleep(&ts, NULL);
+  }
+}
+
+
+
+// Hand the job at the tail to the writer thread and move on to the next
+// slot, waiting for it to be drained if all of them are in flight.  The wait
+// is the only write latency the scanner sees, and is counted as time_write.
+static int async_push(writer_t *w, fs_stats_t *stats)
+{
+  writer_queue_t *q = w->q;
+  const uint64_t tail = q->tail + 1;
+  writer_job_t *job;
+  
+  __atomic_store_n(&q->tail, tail, __ATOMIC_RELEASE);
+  
+  if (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) >= WRITER_NBUFS)
+  {
+    int spins = 0;
+    const double start = stats ? fs_timer_now() : 0.;
+    
+    while (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) >= WRITER_NBUFS)
+      async_wait(&spins);
+    
+    if (stats)
+      stats->time_write += fs_timer_now() - start;
+  }
+  
+  job = q->jobs + tail % WRITER_NBUFS;
+  job->copy = false;
+  job->len = 0;
+  
+  return __atomic_load_n(&q->ret, __ATOMIC_ACQUIRE);
+}
+
+
+
+static int async_write(writer_t *w, const char *buf, size_t len, fs_stats_t *stats)
+{
+  int ret = 0;
+  writer_queue_t *q = w->q;
+  
+  if (stats)
+    stats->bytes_written += len;
+  
+  while (len > 0 && !ret)
+  {
+    writer_job_t *job = q->jobs + q->tail % WRITER_NBUFS;
+    const size_t n = (len < WRITER_BUFLEN - job->len) ? len : (size_t) (WRITER_BUFLEN - job->len);
+    
+    memcpy(job->buf + job->len, buf, n);
+    job->len += n;
+    buf += n;
+    len -= n;
+    
+    if (job->len == WRITER_BUFLEN)
+      ret = async_push(w, stats);
+  }
+  
+  return ret;
+}
+
+
+
+static int async_copy(writer_t *w, const uint64_t offset, const uint64_t len, fs_stats_t *stats)
+{
+  int ret;
+  writer_queue_t *q = w->q;
+  writer_job_t *job = q->jobs + q->tail % WRITER_NBUFS;
+  
+  if (job->len > 0)
+  {
+    ret = async_push(w, stats);
+    if (ret)
+      return ret;
+    
+    job = q->jobs + q->tail % WRITER_NBUFS;
+  }
+  
+  if (stats)
+    stats->bytes_written += len;
+  
+  job->copy = true;
+  job->offset = offset;
+  job->len = len;
+  
+  return async_push(w, stats);
+}
+
+
+
+// copy_run() for the writer thread, which has its own copy method and uses
+// the job's buffer to read back the bytes the kernel won't copy
+static int drain_copy(writer_t *w, int *method, const int fd_out, const writer_job_t *job)
+{
+  uint64_t offset = job->offset;
+  uint64_t len = job->len;
+  
+  while (len > 0 && *method != WRITER_BUFFERED)
+  {
+    int64_t n = copy_once(w->fd_in, *method, fd_out, offset, (size_t) len);
+    if (n < 0)
+      return WRITE_FAIL;
+    else if (n == 0)
+    {
+      (*method)++;
+      continue;
+    }
+    
+    w->nrequests++;
+    w->ncopies++;
+    w->copied += (uint64_t) n;
+    offset += (uint64_t) n;
+    len -= (uint64_t) n;
+  }
+  
+  while (len > 0)
+  {
+    uint64_t nreads = 0;
+    size_t blocklen = (len > WRITER_BUFLEN) ? WRITER_BUFLEN : (size_t) len;
+    
+    if (pread_full(w->fd_in, job->buf, blocklen, offset, &nreads))
+      return READ_FAIL;
+    if (write_full(fd_out, job->buf, blocklen, &w->nrequests))
+      return WRITE_FAIL;
+    
+    offset += blocklen;
+    len -= blocklen;
+  }
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Open a Writer
+ *
+ * @details
+ * Sets up a writer on an open output stream.  If the input is not a
+ * regular file, its byte ranges are simply written to the stream.
+ *
+ * @param w
+ * Output, passed by reference.  The writer to initialize.
+ * @param fp
+ * Input.  The output stream.  It stays open after writer_close().
+ * @param input
+ * Input.  Absolute path to the file the ranges are taken from.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int writer_open(writer_t *w, FILE *fp, const char *input)
+{
+  struct stat sb;
+  
+  memset(w, 0, sizeof(*w));
+  w->fp = fp;
+  w->fd_in = -1;
+  w->method = WRITER_BUFFERED;
+  
+  w->stage = malloc(WRITER_STAGE);
+  if (w->stage == NULL)
+    return MALLOC_FAIL;
+  
+  w->fd_in = open(input, O_RDONLY);
+  if (w->fd_in < 0)
+    return 0;
+  
+  if (fstat(w->fd_in, &sb) != 0 || !S_ISREG(sb.st_mode))
+  {
+    close(w->fd_in);
+    w->fd_in = -1;
+    return 0;
+  }
+  
+  if (fstat(fileno(fp), &sb) == 0 && S_ISFIFO(sb.st_mode))
+    w->method = WRITER_SPLICE;
+  else
+    w->method = WRITER_COPY_RANGE;
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Write a Byte Range
+ *
+ * @details
+ * Writes bytes offset through offset+len-1 of the input.  They are
+ * added to the pending run if they directly follow it, and otherwise
+ * the run is flushed and a new one started.
+ *
+ * @param w
+ * Input/output.  An open writer.
+ * @param buf
+ * Input.  The bytes; they need only stay valid for the call.
+ * @param len,offset
+ * Input.  The length of buf and its position in the input.
+ * @param stats
+ * Output, passed by reference.  If not NULL, write timings and counters
+ * are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int writer_range(writer_t *w, const char *buf, const size_t len, const uint64_t offset, fs_stats_t *stats)
+{
+  int ret;
+  
+  w->nbytes += len;
+  if (w->method == WRITER_BUFFERED)
+  {
+    if (w->q)
+      return async_write(w, buf, len, stats);
+    
+    write_buf(buf, len, w->fp, stats);
+    return 0;
+  }
+  
+  if (w->len > 0 && offset == w->start + w->len)
+  {
+    if (w->len + len <= WRITER_STAGE)
+      memcpy(w->stage + w->len, buf, len);
+    
+    w->len += len;
+    return 0;
+  }
+  
+  ret = writer_flush(w, stats);
+  if (ret)
+    return ret;
+  
+  w->start = offset;
+  w->len = len;
+  if (len <= WRITER_STAGE)
+    memcpy(w->stage, buf, len);
+  
+  return 0;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Copy a Byte Range
+ *
+ * @details
+ * As writer_range(), but for bytes that the caller hasn't read.  If
+ * the kernel can't copy them, they are read back with pread().
+ *
+ * @param w
+ * Input/output.  An open writer.
+ * @param offset,len
+ * Input.  The position and length of the range in the input.
+ * @param stats
+ * Output, passed by reference.  If not NULL, write timings and counters
+ * are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int writer_copy(writer_t *w, const uint64_t offset, const uint64_t len, fs_stats_t *stats)
+{
+  int ret;
+  
+  if (len == 0)
+    return 0;
+  
+  if (w->fd_in < 0)
+    return READ_FAIL;
+  
+  ret = writer_flush(w, stats);
+  if (ret)
+    return ret;
+  
+  w->nbytes += len;
+  if (w->q)
+    return async_copy(w, offset, len, stats);
+  
+  return copy_run(w, offset, len, stats);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Flush a Writer
+ *
+ * @details
+ * Writes out the pending run; short runs go to the stream from the
+ * stage, and long ones are copied by the kernel.  The stream itself is
+ * not flushed.
+ *
+ * @param w
+ * Input/output.  An open writer.
+ * @param stats
+ * Output, passed by reference.  If not NULL, write timings and counters
+ * are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int writer_flush(writer_t *w, fs_stats_t *stats)
+{
+  int ret = 0;
+  
+  if (w->len == 0)
+    return 0;
+  
+  if (w->q && w->len <= WRITER_STAGE)
+    ret = async_write(w, w->stage, (size_t) w->len, stats);
+  else if (w->q)
+    ret = async_copy(w, w->start, w->len, stats);
+  else if (w->len <= WRITER_STAGE)
+    write_buf(w->stage, (size_t) w->len, w->fp, stats);
+  else
+    ret = copy_run(w, w->start, w->len, stats);
+  
+  w->len = 0;
+  return ret;
+}
+
+
+
+// finalize_stats() counts every byte of the output as going through the stdio
+// buffer; swap the copied bytes' share for the copy requests actually made,
+// or everything after async_start for the writer thread's requests.
+void writer_stats(const writer_t *w, fs_stats_t *stats)
+{
+  long total;
+  
+  if (!stats)
+    return;
+  
+  if (w->q)
+  {
+    total = ftell(w->fp);
+    if (total >= 0 && (uint64_t) total >= w->async_start)
+      stats->nwrites -= NWRITES((uint64_t) total) - NWRITES(w->async_start);
+    
+    stats->nwrites += w->nrequests;
+    return;
+  }
+  
+  if (w->copied == 0)
+    return;
+  
+  total = ftell(w->fp);
+  if (total >= 0 && (uint64_t) total >= w->copied)
+    stats->nwrites -= NWRITES((uint64_t) total) - NWRITES((uint64_t) total - w->copied);
+  
+  stats->nwrites += w->ncopies;
+}
+
+
+
+const char* writer_method_name(const writer_t *w)
+{
+  return method_names[w->method];
+}
+
+
+
+void writer_close(writer_t *w)
+{
+  if (w->fd_in >= 0)
+    close(w->fd_in);
+  
+  free(w->stage);
+  w->stage = NULL;
+  
+  free(w->q);
+  free(w->bufs);
+  w->q = NULL;
+  w->bufs = NULL;
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Start Asynchronous Output
+ *
+ * @details
+ * From here on the writer's output is written by a second thread,
+ * which should run writer_async_drain() until the writing thread calls
+ * writer_async_end().  The writing thread fills WRITER_NBUFS buffers
+ * of WRITER_BUFLEN bytes in turn and passes them (and any kernel
+ * copies) to the writer thread through a lock-free queue, so it only
+ * waits for the output if all of the buffers are in flight.  Anything
+ * already written to the stream is flushed first.
+ *
+ * @param w
+ * Input/output.  An open writer with no pending run.
+ *
+ * @return
+ * The return value indicates the status of the function.
+ */
+int writer_async_begin(writer_t *w)
+{
+  long pos;
+  
+  if (fflush(w->fp) != 0 || (pos = ftell(w->fp)) < 0)
+    return WRITE_FAIL;
+  
+  w->q = calloc(1, sizeof(*w->q));
+  w->bufs = malloc((size_t) WRITER_NBUFS * WRITER_BUFLEN);
+  if (w->q == NULL || w->bufs == NULL)
+  {
+    free(w->q);
+    free(w->bufs);
+    w->q = NULL;
+    w->bufs = NULL;
+    return MALLOC_FAIL;
+  }
+  
+  for (int i=0; i<WRITER_NBUFS; i++)
+    w->q->jobs[i].buf = w->bufs + (size_t) i*WRITER_BUFLEN;
+  
+  w->nrequests = 0;
+  w->async_start = (uint64_t) pos;
+  
+  return 0;
+}
+
+
+
+// The writer thread: write out the jobs in order until the queue is empty
+// and writer_async_end() has been called.  After an error the remaining jobs
+// are dropped, and the writing thread sees the error on its next push.
+void writer_async_drain(writer_t *w)
+{
+  writer_queue_t *q = w->q;
+  const int fd_out = fileno(w->fp);
+  int method = w->method;
+  uint64_t head = q->head;
+  int spins = 0;
+  
+  while (true)
+  {
+    writer_job_t *job;
+    int ret = 0;
+    
+    if (head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+    {
+      if (__atomic_load_n(&q->done, __ATOMIC_ACQUIRE) && head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+        break;
+      
+      async_wait(&spins);
+      continue;
+    }
+    
+    spins = 0;
+    job = q->jobs + head % WRITER_NBUFS;
+    
+    if (!__atomic_load_n(&q->ret, __ATOMIC_RELAXED))
+    {
+      if (job->copy)
+        ret = drain_copy(w, &method, fd_out, job);
+      else
+        ret = write_full(fd_out, job->buf, (size_t) job->len, &w->nrequests);
+      
+      if (ret)
+        __atomic_store_n(&q->ret, ret, __ATOMIC_RELEASE);
+    }
+    
+    __atomic_store_n(&q->head, ++head, __ATOMIC_RELEASE);
+  }
+  
+  // keep the stream's idea of its position in step with the file's
+  fseek(w->fp, 0, SEEK_END);
+}
+
+
+
+/**
+ * @file
+ * @brief
+ * Finish Asynchronous Output
+ *
+ * @details
+ * Passes the last buffer to the writer thread and tells it to stop
+ * once the queue is empty.  It must be called even after an error, or
+ * the writer thread never returns.  The output is complete once
+ * writer_async_drain() has returned.
+ *
+ * @param w
+ * Input/output.  A writer after writer_async_begin(), with no pending
+ * run (see writer_flush()).
+ * @param stats
+ * Output, passed by reference.  If not NULL, write timings and counters
+ * are added to it.
+ *
+ * @return
+ * The return value indicates the status of the function, including
+ * any error of the writer thread so far.
+ */
+int writer_async_end(writer_t *w, fs_stats_t *stats)
+{
+  int ret = 0;
+  writer_queue_t *q = w->q;
+  
+  if (q->jobs[q->tail % WRITER_NBUFS].len > 0)
+    ret = async_push(w, stats);
+  
+  __atomic_store_n(&q->done, 1, __ATOMIC_RELEASE);
+  
+  return ret;
+}
@@ -0,0 +1,118 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FILESAMPLER_WRITER_H_
+#define FILESAMPLER_WRITER_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "filesampler.h"
+
+// Runs of input bytes up to this long are written through the stdio buffer;
+// longer ones are copied from the input file by the kernel.
+#define WRITER_STAGE (1 << 16)
+
+// copy methods, in order of preference
+#define WRITER_COPY_RANGE 0
+#define WRITER_SPLICE     1
+#define WRITER_SENDFILE   2
+#define WRITER_BUFFERED   3
+
+// Output buffers of the asynchronous writer; see writer_async_begin()
+#define WRITER_NBUFS  4
+#define WRITER_BUFLEN (1 << 20)
+
+
+// A job for the writer thread: the len bytes of buf, or if copy is set, len
+// bytes of the input from offset (buf is then scratch space)
+typedef struct writer_job_t
+{
+  char *buf;
+  bool copy;
+  uint64_t offset;
+  uint64_t len;
+} writer_job_t;
+
+// Single producer, single consumer ring of jobs.  The scanner fills the job
+// at tail and the writer thread takes the one at head; each index is only
+// ever advanced by its own side, so no locks are needed.
+typedef struct writer_queue_t
+{
+  writer_job_t jobs[WRITER_NBUFS];
+  uint64_t head;
+  uint64_t tail;
+  // set by the scanner after its last job, and by the writer on an error
+  int done;
+  int ret;
+} writer_queue_t;
+
+
+// Output of byte ranges of one input file.  Ranges that are adjacent in the
+// input are merged into a run, and a run that grows past WRITER_STAGE bytes
+// never passes through user space.
+typedef struct writer_t
+{
+  FILE *fp;
+  int fd_in;
+  int method;
+  
+  // pending run, and its bytes while it fits in the stage
+  uint64_t start;
+  uint64_t len;
+  char *stage;
+  
+  // counters
+  uint64_t nbytes;
+  uint64_t copied;
+  uint64_t ncopies;
+  
+  // asynchronous output, if q isn't NULL; the writer thread counts its
+  // requests, and the stream was at async_start when it took over
+  writer_queue_t *q;
+  char *bufs;
+  uint64_t nrequests;
+  uint64_t async_start;
+} writer_t;
+
+
+int writer_open(writer_t *w, FILE *fp, const char *input);
+int writer_range(writer_t *w, const char *buf, const size_t len, const uint64_t offset, fs_stats_t *stats);
+int writer_copy(writer_t *w, const uint64_t offset, const uint64_t len, fs_stats_t *stats);
+int writer_flush(writer_t *w, fs_stats_t *stats);
+void writer_stats(const writer_t *w, fs_stats_t *stats);
+const char* writer_method_name(const writer_t *w);
+void writer_close(writer_t *w);
+
+int writer_async_begin(writer_t *w);
+void writer_async_drain(writer_t *w);
+int writer_async_end(writer_t *w, fs_stats_t *stats);
+
+
+#endif
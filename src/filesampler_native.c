@@ -5,14 +5,60 @@
 #include <R_ext/Rdynload.h>
 #include <stdlib.h>
 
-extern SEXP R_fs_sample_exact(SEXP verbose, SEXP header, SEXP nskip_, SEXP nlines_out_, SEXP input, SEXP output);
-extern SEXP R_fs_sample_prop(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP input, SEXP output);
+extern SEXP R_fs_part_count(SEXP input, SEXP header, SEXP rank, SEXP nranks);
+extern SEXP R_fs_part_split(SEXP nlines_out, SEXP counts_);
+extern SEXP R_fs_profile(SEXP input, SEXP header, SEXP key, SEXP sep, SEXP ntop);
+extern SEXP R_fs_range(SEXP verbose, SEXP header, SEXP first, SEXP last, SEXP input, SEXP output);
+extern SEXP R_fs_read_offsets(SEXP input);
+extern SEXP R_fs_sample_anytime(SEXP verbose, SEXP header, SEXP blocksize_, SEXP time_limit, SEXP byte_limit_, SEXP input, SEXP output);
+extern SEXP R_fs_sample_batch(SEXP verbose, SEXP header, SEXP nested, SEXP max_reads, SEXP nlines_out_, SEXP inputs, SEXP outputs);
+extern SEXP R_fs_sample_block(SEXP verbose, SEXP header, SEXP p, SEXP blocksize_, SEXP input, SEXP output);
+extern SEXP R_fs_sample_bootstrap(SEXP verbose, SEXP header, SEXP nlines_out_, SEXP input, SEXP outputs);
+extern SEXP R_fs_sample_exact(SEXP verbose, SEXP header, SEXP nskip_, SEXP nlines_out_, SEXP format, SEXP input, SEXP output);
+extern SEXP R_fs_sample_hash(SEXP verbose, SEXP header, SEXP p, SEXP seed, SEXP key, SEXP sep, SEXP input, SEXP output);
+extern SEXP R_fs_sample_part(SEXP verbose, SEXP header, SEXP rank, SEXP nranks, SEXP nlines_in, SEXP nlines_out, SEXP input, SEXP output);
+extern SEXP R_fs_sample_prop(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP format, SEXP input, SEXP output);
+extern SEXP R_fs_sample_reservoir(SEXP verbose, SEXP header, SEXP nlines_out_, SEXP input, SEXP output, SEXP state);
+extern SEXP R_fs_sample_split(SEXP verbose, SEXP header, SEXP p, SEXP hash, SEXP seed, SEXP input, SEXP outputs);
+extern SEXP R_fs_sample_systematic(SEXP verbose, SEXP header, SEXP nskip_, SEXP k_, SEXP input, SEXP output);
+extern SEXP R_fs_sample_table(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP sep, SEXP input);
+extern SEXP R_fs_set_cache_mode(SEXP mode);
+extern SEXP R_fs_set_io_backend(SEXP backend);
+extern SEXP R_fs_set_nthreads(SEXP nthreads);
+extern SEXP R_fs_tail(SEXP verbose, SEXP header, SEXP n, SEXP input, SEXP output);
 extern SEXP R_fs_wc(SEXP input, SEXP chars_, SEXP words_, SEXP lines_);
+extern SEXP R_fs_wc_fields(SEXP input, SEXP sep);
+extern SEXP R_fs_wc_incremental(SEXP input, SEXP state);
+extern SEXP R_fs_wc_linelen(SEXP input);
+extern SEXP R_fs_wc_many(SEXP inputs, SEXP chars_, SEXP words_, SEXP lines_);
 
 static const R_CallMethodDef CallEntries[] = {
-  {"R_fs_sample_exact", (DL_FUNC) &R_fs_sample_exact, 6},
-  {"R_fs_sample_prop", (DL_FUNC) &R_fs_sample_prop, 7},
+  {"R_fs_part_count", (DL_FUNC) &R_fs_part_count, 4},
+  {"R_fs_part_split", (DL_FUNC) &R_fs_part_split, 2},
+  {"R_fs_profile", (DL_FUNC) &R_fs_profile, 5},
+  {"R_fs_range", (DL_FUNC) &R_fs_range, 6},
+  {"R_fs_read_offsets", (DL_FUNC) &R_fs_read_offsets, 1},
+  {"R_fs_sample_anytime", (DL_FUNC) &R_fs_sample_anytime, 7},
+  {"R_fs_sample_batch", (DL_FUNC) &R_fs_sample_batch, 7},
+  {"R_fs_sample_block", (DL_FUNC) &R_fs_sample_block, 6},
+  {"R_fs_sample_bootstrap", (DL_FUNC) &R_fs_sample_bootstrap, 5},
+  {"R_fs_sample_exact", (DL_FUNC) &R_fs_sample_exact, 7},
+  {"R_fs_sample_hash", (DL_FUNC) &R_fs_sample_hash, 8},
+  {"R_fs_sample_part", (DL_FUNC) &R_fs_sample_part, 8},
+  {"R_fs_sample_prop", (DL_FUNC) &R_fs_sample_prop, 8},
+  {"R_fs_sample_reservoir", (DL_FUNC) &R_fs_sample_reservoir, 6},
+  {"R_fs_sample_split", (DL_FUNC) &R_fs_sample_split, 7},
+  {"R_fs_sample_systematic", (DL_FUNC) &R_fs_sample_systematic, 6},
+  {"R_fs_sample_table", (DL_FUNC) &R_fs_sample_table, 7},
+  {"R_fs_set_cache_mode", (DL_FUNC) &R_fs_set_cache_mode, 1},
+  {"R_fs_set_io_backend", (DL_FUNC) &R_fs_set_io_backend, 1},
+  {"R_fs_set_nthreads", (DL_FUNC) &R_fs_set_nthreads, 1},
+  {"R_fs_tail", (DL_FUNC) &R_fs_tail, 5},
   {"R_fs_wc", (DL_FUNC) &R_fs_wc, 4},
+  {"R_fs_wc_fields", (DL_FUNC) &R_fs_wc_fields, 2},
+  {"R_fs_wc_incremental", (DL_FUNC) &R_fs_wc_incremental, 2},
+  {"R_fs_wc_linelen", (DL_FUNC) &R_fs_wc_linelen, 1},
+  {"R_fs_wc_many", (DL_FUNC) &R_fs_wc_many, 4},
   {NULL, NULL, 0}
 };
 void R_init_filesampler(DllInfo *dll)
@@ -0,0 +1,94 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+
+#include "Rfilesampler.h"
+
+
+SEXP R_fs_set_io_backend(SEXP backend)
+{
+  return ScalarInteger(fs_set_io_backend(INT(backend)));
+}
+
+
+
+SEXP R_fs_set_cache_mode(SEXP mode)
+{
+  return ScalarInteger(fs_set_cache_mode(INT(mode)));
+}
+
+
+
+SEXP R_fs_set_nthreads(SEXP nthreads)
+{
+  return ScalarInteger(fs_set_nthreads(INT(nthreads)));
+}
+
+
+
+// The records of an offsets output (see fs_offset_t) as an n x 3 matrix
+SEXP R_fs_read_offsets(SEXP input)
+{
+  SEXP ret;
+  FILE *fp;
+  long size;
+  fs_offset_t rec;
+  int n;
+  
+  fp = fopen(CHARPT(input, 0), "rb");
+  if (fp == NULL)
+    fs_checkret(READ_FAIL);
+  
+  size = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
+  if (size < 0 || size % sizeof(rec) != 0)
+  {
+    fclose(fp);
+    fs_checkret(READ_FAIL);
+  }
+  
+  rewind(fp);
+  n = (int) (size / sizeof(rec));
+  PROTECT(ret = allocMatrix(REALSXP, n, 3));
+  
+  for (int i=0; i<n; i++)
+  {
+    if (fread(&rec, sizeof(rec), 1, fp) != 1)
+    {
+      fclose(fp);
+      fs_checkret(READ_FAIL);
+    }
+    
+    REAL(ret)[i] = (double) rec.line;
+    REAL(ret)[i + n] = (double) rec.offset;
+    REAL(ret)[i + 2*n] = (double) rec.len;
+  }
+  
+  fclose(fp);
+  UNPROTECT(1);
+  return ret;
+}
@@ -29,30 +29,375 @@
 #include "filesampler/filesampler.h"
 
 
-SEXP R_fs_sample_prop(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP input, SEXP output)
+SEXP R_fs_sample_prop(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP format, SEXP input, SEXP output)
 {
   int ret;
+  fs_stats_t stats;
   
   const uint32_t nskip = (uint32_t) INT(nskip_);
   const uint32_t nmax = (uint32_t) INT(nmax_);
   
-  ret = fs_sample_prop(INT(verbose), INT(header), nskip, nmax, DBL(p), CHARPT(input, 0), CHARPT(output, 0));
+  fs_stats_init(&stats);
+  ret = fs_sample_prop(INT(verbose), INT(header), nskip, nmax, DBL(p), INT(format), CHARPT(input, 0), CHARPT(output, 0), &stats);
   fs_checkret(ret);
   
-  return R_NilValue;
+  return fs_stats_to_R(&stats);
 }
 
 
 
-SEXP R_fs_sample_exact(SEXP verbose, SEXP header, SEXP nskip_, SEXP nlines_out_, SEXP input, SEXP output)
+SEXP R_fs_sample_exact(SEXP verbose, SEXP header, SEXP nskip_, SEXP nlines_out_, SEXP format, SEXP input, SEXP output)
 {
   int ret;
+  fs_stats_t stats;
+  
+  const uint64_t nskip = (uint64_t) DBL(nskip_);
+  const uint64_t nlines_out = (uint64_t) DBL(nlines_out_);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_exact(INT(verbose), INT(header), nskip, nlines_out, INT(format), CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_reservoir(SEXP verbose, SEXP header, SEXP nlines_out_, SEXP input, SEXP output, SEXP state)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const uint64_t nlines_out = (uint64_t) DBL(nlines_out_);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_reservoir(INT(verbose), INT(header), nlines_out, CHARPT(input, 0), CHARPT(output, 0), CHARPT(state, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_bootstrap(SEXP verbose, SEXP header, SEXP nlines_out_, SEXP input, SEXP outputs)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const uint64_t nlines_out = (uint64_t) DBL(nlines_out_);
+  const int nreps = LENGTH(outputs);
+  const char **outputs_ = (const char**) R_alloc(nreps, sizeof(*outputs_));
+  
+  for (int i=0; i<nreps; i++)
+    outputs_[i] = CHARPT(outputs, i);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_bootstrap(INT(verbose), INT(header), nlines_out, nreps, CHARPT(input, 0), outputs_, &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_batch(SEXP verbose, SEXP header, SEXP nested, SEXP max_reads, SEXP nlines_out_, SEXP inputs, SEXP outputs)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const int nfiles = LENGTH(inputs);
+  const int nreq = LENGTH(nlines_out_);
+  fs_batch_t *batch = (fs_batch_t*) R_alloc(nfiles, sizeof(*batch));
+  uint64_t *nlines_out = (uint64_t*) R_alloc(nreq, sizeof(*nlines_out));
+  
+  for (int i=0; i<nreq; i++)
+    nlines_out[i] = (uint64_t) REAL(nlines_out_)[i];
+  
+  // outputs holds nreq paths per input, input by input
+  for (int f=0; f<nfiles; f++)
+  {
+    const char **outputs_ = (const char**) R_alloc(nreq, sizeof(*outputs_));
+    for (int i=0; i<nreq; i++)
+      outputs_[i] = CHARPT(outputs, f*nreq + i);
+    
+    batch[f].input = CHARPT(inputs, f);
+    batch[f].nreq = nreq;
+    batch[f].nlines_out = nlines_out;
+    batch[f].outputs = outputs_;
+  }
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_exact_batch(INT(verbose), INT(header), INT(nested), INT(max_reads), nfiles, batch, &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_part_count(SEXP input, SEXP header, SEXP rank, SEXP nranks)
+{
+  int ret;
+  uint64_t nlines;
+  
+  ret = fs_part_count(CHARPT(input, 0), INT(header), INT(rank), INT(nranks), &nlines, NULL);
+  fs_checkret(ret);
+  
+  return ScalarReal((double) nlines);
+}
+
+
+
+SEXP R_fs_part_split(SEXP nlines_out, SEXP counts_)
+{
+  int ret;
+  SEXP parts;
+  
+  const int nranks = LENGTH(counts_);
+  uint64_t *counts = (uint64_t*) R_alloc(nranks, sizeof(*counts));
+  uint64_t *nlines_part = (uint64_t*) R_alloc(nranks, sizeof(*nlines_part));
+  
+  for (int r=0; r<nranks; r++)
+    counts[r] = (uint64_t) REAL(counts_)[r];
+  
+  ret = fs_part_split((uint64_t) DBL(nlines_out), nranks, counts, nlines_part);
+  fs_checkret(ret);
+  
+  PROTECT(parts = allocVector(REALSXP, nranks));
+  for (int r=0; r<nranks; r++)
+    REAL(parts)[r] = (double) nlines_part[r];
+  
+  UNPROTECT(1);
+  return parts;
+}
+
+
+
+SEXP R_fs_sample_part(SEXP verbose, SEXP header, SEXP rank, SEXP nranks, SEXP nlines_in, SEXP nlines_out, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_part(INT(verbose), INT(header), INT(rank), INT(nranks), (uint64_t) DBL(nlines_in), (uint64_t) DBL(nlines_out), CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_systematic(SEXP verbose, SEXP header, SEXP nskip_, SEXP k_, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const uint32_t nskip = (uint32_t) INT(nskip_);
+  const uint64_t k = (uint64_t) INT(k_);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_systematic(INT(verbose), INT(header), nskip, k, CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_block(SEXP verbose, SEXP header, SEXP p, SEXP blocksize_, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const uint64_t blocksize = (uint64_t) DBL(blocksize_);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_block(INT(verbose), INT(header), DBL(p), blocksize, CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_anytime(SEXP verbose, SEXP header, SEXP blocksize_, SEXP time_limit, SEXP byte_limit_, SEXP input, SEXP output)
+{
+  SEXP ret;
+  int check;
+  int stopped;
+  double coverage;
+  fs_stats_t stats;
+  
+  const uint64_t blocksize = (uint64_t) DBL(blocksize_);
+  const uint64_t byte_limit = (uint64_t) DBL(byte_limit_);
+  
+  fs_stats_init(&stats);
+  check = fs_sample_anytime(INT(verbose), INT(header), blocksize, DBL(time_limit), byte_limit, CHARPT(input, 0), CHARPT(output, 0), &coverage, &stopped, &stats);
+  fs_checkret(check);
+  
+  PROTECT(ret = allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(ret, 0, fs_stats_to_R(&stats));
+  SET_VECTOR_ELT(ret, 1, ScalarReal(coverage));
+  SET_VECTOR_ELT(ret, 2, ScalarInteger(stopped));
+  
+  UNPROTECT(1);
+  return ret;
+}
+
+
+
+SEXP R_fs_sample_split(SEXP verbose, SEXP header, SEXP p, SEXP hash, SEXP seed, SEXP input, SEXP outputs)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const int nout = LENGTH(outputs);
+  const char **outputs_ = (const char**) R_alloc(nout, sizeof(*outputs_));
+  for (int i=0; i<nout; i++)
+    outputs_[i] = CHARPT(outputs, i);
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_split(INT(verbose), INT(header), nout, REAL(p), INT(hash), (uint64_t) DBL(seed), CHARPT(input, 0), outputs_, &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_sample_hash(SEXP verbose, SEXP header, SEXP p, SEXP seed, SEXP key, SEXP sep, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  const uint32_t key_ = (uint32_t) INT(key);
+  const char sep_ = CHARPT(sep, 0)[0];
+  
+  fs_stats_init(&stats);
+  ret = fs_sample_hash(INT(verbose), INT(header), DBL(p), (uint64_t) DBL(seed), key_, sep_, CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+// Copy a sampled table into R.  Runs under R_UnwindProtect(), so that the
+// table is freed even if an allocation here longjmps.
+static SEXP table_to_R(void *data)
+{
+  SEXP ret, names, cols, x;
+  const fs_table_t *table = (const fs_table_t*) data;
+  
+  PROTECT(ret = allocVector(VECSXP, 2));
+  PROTECT(cols = allocVector(VECSXP, table->ncols));
+  
+  if (table->names)
+  {
+    PROTECT(names = allocVector(STRSXP, table->ncols));
+    for (int j=0; j<table->ncols; j++)
+      SET_STRING_ELT(names, j, mkCharLen(table->text + table->names[j].start, (int) table->names[j].len));
+  }
+  else
+    PROTECT(names = R_NilValue);
+  
+  // each column is parsed straight into its vector
+  for (int j=0; j<table->ncols; j++)
+  {
+    const R_xlen_t n = (R_xlen_t) table->nrows;
+    
+    switch (table->types[j])
+    {
+      case FS_COL_LOGICAL:
+        x = allocVector(LGLSXP, n);
+        SET_VECTOR_ELT(cols, j, x);
+        fs_table_fill_int(table, j, LOGICAL(x), NA_LOGICAL);
+        break;
+      case FS_COL_INTEGER:
+        x = allocVector(INTSXP, n);
+        SET_VECTOR_ELT(cols, j, x);
+        fs_table_fill_int(table, j, INTEGER(x), NA_INTEGER);
+        break;
+      case FS_COL_DOUBLE:
+        x = allocVector(REALSXP, n);
+        SET_VECTOR_ELT(cols, j, x);
+        fs_table_fill_double(table, j, REAL(x), NA_REAL);
+        break;
+      default:
+        x = allocVector(STRSXP, n);
+        SET_VECTOR_ELT(cols, j, x);
+        for (R_xlen_t i=0; i<n; i++)
+        {
+          const char *s;
+          size_t len;
+          if (fs_table_field(table, (uint64_t) i, j, &s, &len))
+            SET_STRING_ELT(x, i, mkCharLen(s, (int) len));
+          else
+            SET_STRING_ELT(x, i, NA_STRING);
+        }
+    }
+  }
+  
+  SET_VECTOR_ELT(ret, 0, names);
+  SET_VECTOR_ELT(ret, 1, cols);
+  
+  UNPROTECT(3);
+  return ret;
+}
+
+
+
+// called on both normal exit and a longjmp out of table_to_R()
+static void table_cleanup(void *data, Rboolean jump)
+{
+  fs_table_free((fs_table_t*) data);
+}
+
+
+
+SEXP R_fs_sample_table(SEXP verbose, SEXP header, SEXP nskip_, SEXP nmax_, SEXP p, SEXP sep, SEXP input)
+{
+  SEXP ret, cont;
+  int check;
+  fs_table_t table;
   
   const uint32_t nskip = (uint32_t) INT(nskip_);
-  const uint32_t nlines_out = (uint32_t) INT(nlines_out_);
+  const uint32_t nmax = (uint32_t) INT(nmax_);
+  
+  check = fs_sample_table(INT(verbose), INT(header), nskip, nmax, DBL(p), CHARPT(sep, 0)[0], CHARPT(input, 0), &table, NULL);
+  fs_checkret(check);
+  
+  PROTECT(cont = R_MakeUnwindCont());
+  ret = R_UnwindProtect(table_to_R, &table, table_cleanup, &table, cont);
+  
+  UNPROTECT(1);
+  return ret;
+}
+
+
+
+SEXP R_fs_tail(SEXP verbose, SEXP header, SEXP n, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
+  
+  fs_stats_init(&stats);
+  ret = fs_tail(INT(verbose), INT(header), (uint64_t) DBL(n), CHARPT(input, 0), CHARPT(output, 0), &stats);
+  fs_checkret(ret);
+  
+  return fs_stats_to_R(&stats);
+}
+
+
+
+SEXP R_fs_range(SEXP verbose, SEXP header, SEXP first, SEXP last, SEXP input, SEXP output)
+{
+  int ret;
+  fs_stats_t stats;
   
-  ret = fs_sample_exact(INT(verbose), INT(header), nskip, nlines_out, CHARPT(input, 0), CHARPT(output, 0));
+  fs_stats_init(&stats);
+  ret = fs_range(INT(verbose), INT(header), (uint64_t) DBL(first), (uint64_t) DBL(last), CHARPT(input, 0), CHARPT(output, 0), &stats);
   fs_checkret(ret);
   
-  return R_NilValue;
+  return fs_stats_to_R(&stats);
 }
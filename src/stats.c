@@ -0,0 +1,72 @@
+/*  Copyright (c) 2026, Drew Schmidt
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+    CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+    EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+    PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Rfilesampler.h"
+
+#define NSTATS 13
+
+
+SEXP fs_stats_to_R(const fs_stats_t *stats)
+{
+  SEXP ret, ret_names;
+  
+  PROTECT(ret = allocVector(VECSXP, NSTATS));
+  PROTECT(ret_names = allocVector(STRSXP, NSTATS));
+  
+  SET_VECTOR_ELT(ret, 0, ScalarReal(stats->time_count));
+  SET_VECTOR_ELT(ret, 1, ScalarReal(stats->time_index));
+  SET_VECTOR_ELT(ret, 2, ScalarReal(stats->time_sort));
+  SET_VECTOR_ELT(ret, 3, ScalarReal(stats->time_sample));
+  SET_VECTOR_ELT(ret, 4, ScalarReal(stats->time_write));
+  SET_VECTOR_ELT(ret, 5, ScalarReal((double) stats->bytes_read));
+  SET_VECTOR_ELT(ret, 6, ScalarReal((double) stats->bytes_written));
+  SET_VECTOR_ELT(ret, 7, ScalarReal((double) stats->lines_read));
+  SET_VECTOR_ELT(ret, 8, ScalarReal((double) stats->lines_written));
+  SET_VECTOR_ELT(ret, 9, ScalarReal((double) stats->nreads));
+  SET_VECTOR_ELT(ret, 10, ScalarReal((double) stats->nwrites));
+  SET_VECTOR_ELT(ret, 11, mkString(stats->kernel ? stats->kernel : "none"));
+  SET_VECTOR_ELT(ret, 12, mkString(stats->backend ? stats->backend : "none"));
+  
+  SET_STRING_ELT(ret_names, 0, mkChar("time_count"));
+  SET_STRING_ELT(ret_names, 1, mkChar("time_index"));
+  SET_STRING_ELT(ret_names, 2, mkChar("time_sort"));
+  SET_STRING_ELT(ret_names, 3, mkChar("time_sample"));
+  SET_STRING_ELT(ret_names, 4, mkChar("time_write"));
+  SET_STRING_ELT(ret_names, 5, mkChar("bytes_read"));
+  SET_STRING_ELT(ret_names, 6, mkChar("bytes_written"));
+  SET_STRING_ELT(ret_names, 7, mkChar("lines_read"));
+  SET_STRING_ELT(ret_names, 8, mkChar("lines_written"));
+  SET_STRING_ELT(ret_names, 9, mkChar("nreads"));
+  SET_STRING_ELT(ret_names, 10, mkChar("nwrites"));
+  SET_STRING_ELT(ret_names, 11, mkChar("kernel"));
+  SET_STRING_ELT(ret_names, 12, mkChar("backend"));
+  
+  setAttrib(ret, R_NamesSymbol, ret_names);
+  
+  UNPROTECT(2);
+  return ret;
+}
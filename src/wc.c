@@ -48,7 +48,7 @@ SEXP R_fs_wc(SEXP input, SEXP chars_, SEXP words_, SEXP lines_)
   
   PROTECT(counts = allocVector(REALSXP, 3));
   
-  ret = fs_wc(CHARPT(input, 0), chars, &nchars, words, &nwords, lines, &nlines);
+  ret = fs_wc(CHARPT(input, 0), chars, &nchars, words, &nwords, lines, &nlines, NULL);
   fs_checkret(ret);
   
   COUNTS(NCHARS) = chars ? (double) nchars : BADVAL;
@@ -58,3 +58,148 @@ SEXP R_fs_wc(SEXP input, SEXP chars_, SEXP words_, SEXP lines_)
   UNPROTECT(1);
   return counts;
 }
+
+
+
+SEXP R_fs_wc_many(SEXP inputs, SEXP chars_, SEXP words_, SEXP lines_)
+{
+  SEXP counts;
+  int ret;
+  
+  const int nfiles = LENGTH(inputs);
+  const bool chars = INT(chars_);
+  const bool words = INT(words_);
+  const bool lines = INT(lines_);
+  const char **files = (const char**) R_alloc(nfiles, sizeof(*files));
+  uint64_t *nchars = (uint64_t*) R_alloc(nfiles, sizeof(*nchars));
+  uint64_t *nwords = (uint64_t*) R_alloc(nfiles, sizeof(*nwords));
+  uint64_t *nlines = (uint64_t*) R_alloc(nfiles, sizeof(*nlines));
+  
+  for (int f=0; f<nfiles; f++)
+    files[f] = CHARPT(inputs, f);
+  
+  ret = fs_wc_many(nfiles, files, chars, nchars, words, nwords, lines, nlines, NULL);
+  fs_checkret(ret);
+  
+  // one row of counts per file
+  PROTECT(counts = allocMatrix(REALSXP, nfiles, 3));
+  
+  for (int f=0; f<nfiles; f++)
+  {
+    REAL(counts)[f + NCHARS*nfiles] = chars ? (double) nchars[f] : BADVAL;
+    REAL(counts)[f + NWORDS*nfiles] = words ? (double) nwords[f] : BADVAL;
+    REAL(counts)[f + NLINES*nfiles] = lines ? (double) nlines[f] : BADVAL;
+  }
+  
+  UNPROTECT(1);
+  return counts;
+}
+
+
+
+SEXP R_fs_wc_incremental(SEXP input, SEXP state)
+{
+  SEXP counts;
+  int ret;
+  uint64_t nlines;
+  
+  PROTECT(counts = allocVector(REALSXP, 3));
+  
+  ret = fs_wc_incremental(CHARPT(input, 0), CHARPT(state, 0), &nlines, NULL);
+  fs_checkret(ret);
+  
+  COUNTS(NCHARS) = BADVAL;
+  COUNTS(NWORDS) = BADVAL;
+  COUNTS(NLINES) = (double) nlines;
+  
+  UNPROTECT(1);
+  return counts;
+}
+
+
+
+SEXP R_fs_wc_linelen(SEXP input)
+{
+  SEXP ret;
+  int check;
+  fs_linelen_t ll;
+  
+  PROTECT(ret = allocVector(REALSXP, 4 + FS_LINELEN_NBUCKETS));
+  
+  check = fs_wc_linelen(CHARPT(input, 0), &ll, NULL);
+  fs_checkret(check);
+  
+  REAL(ret)[0] = (double) ll.nlines;
+  REAL(ret)[1] = (double) ll.nchars;
+  REAL(ret)[2] = (double) ll.min;
+  REAL(ret)[3] = (double) ll.max;
+  for (int b=0; b<FS_LINELEN_NBUCKETS; b++)
+    REAL(ret)[4 + b] = (double) ll.counts[b];
+  
+  UNPROTECT(1);
+  return ret;
+}
+
+
+
+
+SEXP R_fs_wc_fields(SEXP input, SEXP sep)
+{
+  SEXP ret;
+  int check;
+  int nkept;
+  fs_fields_t f;
+  
+  check = fs_wc_fields(CHARPT(input, 0), CHARPT(sep, 0)[0], &f, NULL);
+  fs_checkret(check);
+  
+  nkept = (f.nanomalies < FS_FIELDS_NANOMALIES) ? (int) f.nanomalies : FS_FIELDS_NANOMALIES;
+  PROTECT(ret = allocVector(REALSXP, 6 + nkept));
+  
+  REAL(ret)[0] = (double) f.nlines;
+  REAL(ret)[1] = (double) f.nchars;
+  REAL(ret)[2] = (double) f.nfields;
+  REAL(ret)[3] = (double) f.min;
+  REAL(ret)[4] = (double) f.max;
+  REAL(ret)[5] = (double) f.nanomalies;
+  for (int i=0; i<nkept; i++)
+    REAL(ret)[6 + i] = (double) f.anomalies[i];
+  
+  UNPROTECT(1);
+  return ret;
+}
+
+
+
+
+SEXP R_fs_profile(SEXP input, SEXP header, SEXP key, SEXP sep, SEXP ntop)
+{
+  SEXP ret, top, top_counts;
+  int check;
+  fs_profile_t profile;
+  
+  check = fs_profile(CHARPT(input, 0), INT(header), (uint32_t) INT(key), CHARPT(sep, 0)[0], INT(ntop), &profile, NULL);
+  fs_checkret(check);
+  
+  PROTECT(ret = allocVector(VECSXP, 6));
+  PROTECT(top = allocVector(STRSXP, profile.ntop));
+  PROTECT(top_counts = allocVector(REALSXP, profile.ntop));
+  
+  for (int i=0; i<profile.ntop; i++)
+  {
+    SET_STRING_ELT(top, i, mkChar(profile.top[i]));
+    REAL(top_counts)[i] = (double) profile.top_counts[i];
+  }
+  
+  SET_VECTOR_ELT(ret, 0, ScalarReal((double) profile.nlines));
+  SET_VECTOR_ELT(ret, 1, ScalarReal((double) profile.nchars));
+  SET_VECTOR_ELT(ret, 2, ScalarReal(profile.distinct_lines));
+  SET_VECTOR_ELT(ret, 3, ScalarReal(profile.distinct_keys));
+  SET_VECTOR_ELT(ret, 4, top);
+  SET_VECTOR_ELT(ret, 5, top_counts);
+  
+  fs_profile_free(&profile);
+  
+  UNPROTECT(3);
+  return ret;
+}